@@ -0,0 +1,21 @@
+QT += core gui widgets testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = autotests
+
+HEADERS += \
+    test_constraintsolver.h \
+    test_keyedbox.h \
+    test_layoutsnapshot.h \
+    test_layouts.h
+
+SOURCES += \
+    main.cpp \
+    test_constraintsolver.cpp \
+    test_keyedbox.cpp \
+    test_layoutsnapshot.cpp \
+    test_layouts.cpp
+
+INCLUDEPATH += ..
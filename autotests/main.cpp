@@ -0,0 +1,34 @@
+#include <QApplication>
+#include <QtTest>
+
+#include "test_constraintsolver.h"
+#include "test_keyedbox.h"
+#include "test_layoutsnapshot.h"
+#include "test_layouts.h"
+
+//
+// Runs the correctness tests of the qtutils headers. The tests run headless
+// on the offscreen platform plugin unless QT_QPA_PLATFORM is set. All usual
+// QtTest arguments are passed to each test class. "make check" runs them.
+//
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    TestLayouts layouts;
+    TestKeyedBox keyedBox;
+    TestConstraintSolver constraintSolver;
+    TestLayoutSnapshot layoutSnapshot;
+    QObject *tests[] = { &layouts, &keyedBox, &constraintSolver, &layoutSnapshot };
+
+    int status = 0;
+    for (QObject *test : tests) {
+        status |= QTest::qExec(test, app.arguments());
+    }
+    return status;
+}
@@ -0,0 +1,115 @@
+#include "test_constraintsolver.h"
+
+#include <QtTest>
+
+#include "qtutils/constraintsolver.h"
+
+/**
+ * @brief Returns the value of a variable rounded to an integer. The known
+ * solutions below are integral, rounding hides the floating point error of
+ * the pivots.
+ */
+static int valueOf(const Variable &variable)
+{
+    return qRound(variable.value());
+}
+
+void TestConstraintSolver::addConstraintSolves()
+{
+    Variable left, width, right;
+    ConstraintSolver solver;
+    QVERIFY(solver.addConstraint(right == left + width));
+    QVERIFY(solver.addConstraint(left >= 10));
+    QVERIFY(solver.addConstraint((left == 0) | Strength::Weak));
+    QVERIFY(solver.addConstraint((width == 100) | Strength::Medium));
+    solver.updateVariables();
+
+    // The required minimum beats the weak preference of the left edge.
+    QCOMPARE(valueOf(left), 10);
+    QCOMPARE(valueOf(width), 100);
+    QCOMPARE(valueOf(right), 110);
+
+    // A stronger constraint beats the preferred width.
+    QVERIFY(solver.addConstraint((right <= 80) | Strength::Strong));
+    solver.updateVariables();
+    QCOMPARE(valueOf(left), 10);
+    QCOMPARE(valueOf(width), 70);
+    QCOMPARE(valueOf(right), 80);
+
+    // A conflicting required constraint is refused.
+    const Constraint conflicting = left <= 5;
+    QVERIFY(!solver.addConstraint(conflicting));
+    QVERIFY(!solver.hasConstraint(conflicting));
+    QCOMPARE(solver.constraintCount(), 5);
+}
+
+void TestConstraintSolver::removeConstraintRestores()
+{
+    Variable left, width;
+    ConstraintSolver solver;
+    const Constraint preferred = (width == 100) | Strength::Medium;
+    const Constraint bound = (left + width <= 60) | Strength::Strong;
+    const Constraint shifted = left == 20;
+    QVERIFY(solver.addConstraint(left >= 0));
+    QVERIFY(solver.addConstraint(width >= 0));
+    QVERIFY(solver.addConstraint(preferred));
+    QVERIFY(solver.addConstraint(bound));
+    QVERIFY(solver.addConstraint(shifted));
+    solver.updateVariables();
+    QCOMPARE(valueOf(left), 20);
+    QCOMPARE(valueOf(width), 40);
+
+    QVERIFY(solver.removeConstraint(shifted));
+    solver.updateVariables();
+    QCOMPARE(valueOf(left), 0);
+    QCOMPARE(valueOf(width), 60);
+
+    QVERIFY(solver.removeConstraint(bound));
+    solver.updateVariables();
+    QCOMPARE(valueOf(width), 100);
+
+    // A constraint can be removed once and added again.
+    QVERIFY(!solver.removeConstraint(bound));
+    QVERIFY(solver.addConstraint(bound));
+    solver.updateVariables();
+    QCOMPARE(valueOf(left), 0);
+    QCOMPARE(valueOf(width), 60);
+    QCOMPARE(solver.constraintCount(), 4);
+}
+
+void TestConstraintSolver::suggestValueFollowsStrengths()
+{
+    Variable left, width, right;
+    ConstraintSolver solver;
+    QVERIFY(solver.addConstraint(right == left + width));
+    QVERIFY(solver.addConstraint(left == 10));
+    QVERIFY(solver.addConstraint(width >= 60));
+    QVERIFY(solver.addConstraint(right <= 200));
+    QVERIFY(solver.addConstraint((width == 100) | Strength::Weak));
+    QVERIFY(solver.addEditVariable(width, Strength::Strong));
+    QVERIFY(!solver.addEditVariable(right, Strength::Required));
+
+    // The suggestion beats the weak preference, the required constraints
+    // bound it from both sides.
+    QVERIFY(solver.suggestValue(width, 150));
+    solver.updateVariables();
+    QCOMPARE(valueOf(width), 150);
+    QCOMPARE(valueOf(right), 160);
+
+    QVERIFY(solver.suggestValue(width, 240));
+    solver.updateVariables();
+    QCOMPARE(valueOf(width), 190);
+    QCOMPARE(valueOf(right), 200);
+
+    QVERIFY(solver.suggestValue(width, 20));
+    solver.updateVariables();
+    QCOMPARE(valueOf(width), 60);
+    QCOMPARE(valueOf(right), 70);
+
+    // Without the edit variable the weak preference applies again.
+    QVERIFY(solver.removeEditVariable(width));
+    QVERIFY(!solver.suggestValue(width, 150));
+    solver.updateVariables();
+    QCOMPARE(valueOf(width), 100);
+    QCOMPARE(valueOf(right), 110);
+}
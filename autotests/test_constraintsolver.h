@@ -0,0 +1,13 @@
+#pragma once
+
+#include <QObject>
+
+class TestConstraintSolver : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void addConstraintSolves();
+    void removeConstraintRestores();
+    void suggestValueFollowsStrengths();
+};
@@ -0,0 +1,100 @@
+#include "test_keyedbox.h"
+
+#include <QtTest>
+
+#include "qtutils/keyedbox.h"
+
+/**
+ * @brief Returns keyed children of plain widgets for single-letter keys.
+ */
+static QVector<Keyed> keyed(const QString &keys)
+{
+    QVector<Keyed> items;
+    for (const QChar key : keys) {
+        items << Keyed(key, [] { return new QWidget(); });
+    }
+    return items;
+}
+
+/**
+ * @brief Returns the keys of the widgets in the layout in their order.
+ */
+static QString keysOf(QBoxLayout *layout, const KeyedBox &box, const QString &keys)
+{
+    QString result;
+    for (int i = 0; i < layout->count(); ++i) {
+        for (const QChar key : keys) {
+            if (layout->itemAt(i)->widget() == box.widget(key)) {
+                result += key;
+            }
+        }
+    }
+    return result;
+}
+
+void TestKeyedBox::reorderMovesFewest_data()
+{
+    QTest::addColumn<QString>("before");
+    QTest::addColumn<QString>("after");
+    QTest::addColumn<int>("inserted");
+    QTest::addColumn<int>("removed");
+    QTest::addColumn<int>("moved");
+
+    QTest::newRow("unchanged") << "ABCDE" << "ABCDE" << 0 << 0 << 0;
+    QTest::newRow("first to last") << "ABCDE" << "BCDEA" << 0 << 0 << 1;
+    QTest::newRow("last to first") << "ABCDE" << "EABCD" << 0 << 0 << 1;
+    QTest::newRow("swap") << "ABCDE" << "ADCBE" << 0 << 0 << 2;
+    QTest::newRow("reverse") << "ABCDE" << "EDCBA" << 0 << 0 << 4;
+    QTest::newRow("interleaved") << "ABCDEF" << "DAEBFC" << 0 << 0 << 3;
+    QTest::newRow("mixed") << "BCDEA" << "EAFBD" << 1 << 1 << 2;
+    QTest::newRow("replace all") << "ABC" << "XYZ" << 3 << 3 << 0;
+}
+
+void TestKeyedBox::reorderMovesFewest()
+{
+    QFETCH(QString, before);
+    QFETCH(QString, after);
+    QFETCH(int, inserted);
+    QFETCH(int, removed);
+    QFETCH(int, moved);
+
+    QWidget window;
+    QBoxLayout *layout = VBox(&window);
+    KeyedBox box(layout);
+    box.apply(keyed(before));
+    QCOMPARE(box.insertedCount(), before.size());
+    QCOMPARE(keysOf(layout, box, before), before);
+
+    box.apply(keyed(after));
+    QCOMPARE(box.insertedCount(), inserted);
+    QCOMPARE(box.removedCount(), removed);
+    QCOMPARE(box.movedCount(), moved);
+    QCOMPARE(layout->count(), after.size());
+    QCOMPARE(keysOf(layout, box, after), after);
+}
+
+void TestKeyedBox::keepsWidgets()
+{
+    QWidget window;
+    QBoxLayout *layout = HBox(&window);
+    KeyedBox box(layout);
+    box.apply(keyed("ABC") << Keyed("stretch", Stretch(1)));
+
+    QPointer<QWidget> a = box.widget("A");
+    QPointer<QWidget> b = box.widget("B");
+    QPointer<QWidget> c = box.widget("C");
+
+    // Moved widgets are the same objects, only the removed one is deleted.
+    // The stretch stays in place and keeps its factor.
+    box.apply(QVector<Keyed>() << Keyed("stretch", Stretch(1)) << keyed("CA"));
+    QCOMPARE(box.movedCount(), 2);
+    QCOMPARE(box.removedCount(), 1);
+    QVERIFY(b.isNull());
+    QCOMPARE(box.widget("A"), a.data());
+    QCOMPARE(box.widget("C"), c.data());
+    QCOMPARE(layout->count(), 3);
+    QVERIFY(layout->itemAt(0)->spacerItem());
+    QCOMPARE(layout->stretch(0), 1);
+    QCOMPARE(layout->itemAt(1)->widget(), c.data());
+    QCOMPARE(layout->itemAt(2)->widget(), a.data());
+}
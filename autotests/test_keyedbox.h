@@ -0,0 +1,13 @@
+#pragma once
+
+#include <QObject>
+
+class TestKeyedBox : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void reorderMovesFewest_data();
+    void reorderMovesFewest();
+    void keepsWidgets();
+};
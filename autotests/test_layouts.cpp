@@ -0,0 +1,785 @@
+#include "test_layouts.h"
+
+#include <QCommonStyle>
+#include <QtTest>
+
+#include "qtutils/breakpoints.h"
+#include "qtutils/constraintlayout.h"
+#include "qtutils/flowlayout.h"
+#include "qtutils/geometrybox.h"
+#include "qtutils/geometrycache.h"
+#include "qtutils/layouts.h"
+#include "qtutils/resizecoalescing.h"
+#include "qtutils/sizegroup.h"
+#include "qtutils/stylemetrics.h"
+
+/**
+ * @brief Widget with explicit minimum size and size hint, square so that it
+ * can be used in both directions.
+ */
+class HintWidget : public QWidget
+{
+public:
+    HintWidget(int minimum, int hint, QSizePolicy::Policy policy = QSizePolicy::Preferred)
+        : m_minimum(minimum, minimum)
+        , m_hint(hint, hint)
+    {
+        setSizePolicy(policy, policy);
+    }
+
+    QSize minimumSizeHint() const override { return m_minimum; }
+
+    QSize sizeHint() const override { return m_hint; }
+
+    void setHint(int hint)
+    {
+        m_hint = QSize(hint, hint);
+        updateGeometry();
+    }
+
+private:
+    QSize m_minimum;
+    QSize m_hint;
+};
+
+/**
+ * @brief Style with the same layout margins and spacing, which can be
+ * changed to emulate a change of the device pixel ratio.
+ */
+class MetricStyle : public QCommonStyle
+{
+public:
+    explicit MetricStyle(int metric)
+        : m_metric(metric)
+    {}
+
+    void setMetric(int metric) { m_metric = metric; }
+
+    int pixelMetric(PixelMetric metric, const QStyleOption *option = nullptr,
+                    const QWidget *widget = nullptr) const override
+    {
+        switch (metric) {
+        case PM_LayoutLeftMargin:
+        case PM_LayoutTopMargin:
+        case PM_LayoutRightMargin:
+        case PM_LayoutBottomMargin:
+        case PM_LayoutHorizontalSpacing:
+        case PM_LayoutVerticalSpacing:
+            return m_metric;
+        default:
+            return QCommonStyle::pixelMetric(metric, option, widget);
+        }
+    }
+
+private:
+    int m_metric;
+};
+
+/**
+ * @brief Fills a box layout with one of the fixtures comparing LinearLayout
+ * with QBoxLayout.
+ */
+static void fillFixture(QBoxLayout *box, const QString &fixture)
+{
+    box->setContentsMargins(3, 4, 5, 6);
+    box->setSpacing(6);
+    if (fixture == QLatin1String("preferred")) {
+        box->addWidget(new HintWidget(20, 50));
+        box->addWidget(new HintWidget(40, 80));
+        box->addWidget(new HintWidget(10, 30));
+    } else if (fixture == QLatin1String("stretched")) {
+        box->addWidget(new HintWidget(20, 50), 1);
+        box->addWidget(new HintWidget(30, 30, QSizePolicy::Fixed));
+        box->addWidget(new HintWidget(40, 80), 2);
+    } else if (fixture == QLatin1String("expanding")) {
+        box->addWidget(new HintWidget(10, 40, QSizePolicy::Expanding));
+        auto bounded = new HintWidget(20, 60);
+        bounded->setMaximumSize(90, 90);
+        box->addWidget(bounded);
+        box->addWidget(new HintWidget(10, 20));
+    } else if (fixture == QLatin1String("hidden")) {
+        box->addWidget(new HintWidget(20, 50));
+        auto hidden = new HintWidget(30, 70);
+        box->addWidget(hidden, 3);
+        hidden->hide();
+        box->addWidget(new HintWidget(10, 40), 1);
+    } else if (fixture == QLatin1String("spacers")) {
+        box->addWidget(new HintWidget(20, 50));
+        box->addSpacing(10);
+        box->addWidget(new HintWidget(10, 40));
+        box->addStretch(1);
+        box->addWidget(new HintWidget(30, 30, QSizePolicy::Fixed));
+    } else if (fixture == QLatin1String("defaultSpacing")) {
+        // The spacing of the style between each pair of items.
+        box->setSpacing(-1);
+        box->addWidget(new HintWidget(20, 50));
+        box->addSpacing(10);
+        box->addWidget(new HintWidget(40, 80), 1);
+        box->addWidget(new HintWidget(10, 30));
+    }
+}
+
+/**
+ * @brief Returns the cell of a widget in a grid layout as a rectangle of
+ * columns and rows, i.e. x and y are the column and the row, width and height
+ * are the column and row spans.
+ */
+static QRect cellOf(QGridLayout *grid, QWidget *widget)
+{
+    int row = -1;
+    int column = -1;
+    int rowSpan = 0;
+    int columnSpan = 0;
+    const int index = grid->indexOf(widget);
+    if (index >= 0) {
+        grid->getItemPosition(index, &row, &column, &rowSpan, &columnSpan);
+    }
+    return QRect(column, row, columnSpan, rowSpan);
+}
+
+/**
+ * @brief Returns a widget with the object name, which identifies it in
+ * describe().
+ */
+static QWidget *named(const char *name)
+{
+    auto widget = new QWidget();
+    widget->setObjectName(QLatin1String(name));
+    return widget;
+}
+
+/**
+ * @brief Describes the items of a box layout, i.e. the names of widgets or
+ * the sizes of spacers, with their stretch factors and alignments, so that
+ * layouts with different widgets can be compared.
+ */
+static QStringList describe(QBoxLayout *box)
+{
+    QStringList items;
+    for (int i = 0; i < box->count(); ++i) {
+        QLayoutItem *item = box->itemAt(i);
+        QString text;
+        if (item->widget()) {
+            text = item->widget()->objectName();
+        } else if (item->spacerItem()) {
+            const QSize size = item->spacerItem()->sizeHint();
+            text = QStringLiteral("spacer %1x%2").arg(size.width()).arg(size.height());
+        } else {
+            text = QStringLiteral("layout");
+        }
+        items.append(QStringLiteral("%1/%2/%3")
+                         .arg(text)
+                         .arg(box->stretch(i))
+                         .arg(int(item->alignment())));
+    }
+    return items;
+}
+
+void TestLayouts::gridAutoPlacement()
+{
+    QWidget window;
+    auto a = new QWidget();
+    auto b = new QWidget();
+    auto c = new QWidget();
+    auto d = new QWidget();
+    auto e = new QWidget();
+    auto f = new QWidget();
+    auto g = new QWidget();
+
+    // Explicit cells are reserved before the other children flow around
+    // them, spanning children go to the first position where they fit.
+    QGridLayout *grid = Grid(&window).setColumns(3)
+                        << a << Span(b, 1, 2) << Span(c, 2, 1) << d << Cell(e, 1, 1) << f << g;
+
+    QCOMPARE(grid->count(), 7);
+    QCOMPARE(cellOf(grid, a), QRect(0, 0, 1, 1));
+    QCOMPARE(cellOf(grid, b), QRect(1, 0, 2, 1));
+    QCOMPARE(cellOf(grid, c), QRect(0, 1, 1, 2));
+    QCOMPARE(cellOf(grid, d), QRect(2, 1, 1, 1));
+    QCOMPARE(cellOf(grid, e), QRect(1, 1, 1, 1));
+    QCOMPARE(cellOf(grid, f), QRect(1, 2, 1, 1));
+    QCOMPARE(cellOf(grid, g), QRect(2, 2, 1, 1));
+}
+
+void TestLayouts::gridPlacementAcrossCommits()
+{
+    QWidget window;
+    auto a = new QWidget();
+    auto b = new QWidget();
+    auto c = new QWidget();
+    auto d = new QWidget();
+    QWidget *missing = nullptr;
+
+    // A nullptr child keeps its cell, a span wider than the grid is clamped
+    // to the number of columns and placement continues after a commit.
+    auto grid = Grid(&window).setColumns(3);
+    grid << a << missing << b;
+    grid.commit();
+    grid << Span(c, 1, 5) << d;
+    QGridLayout *layout = grid;
+
+    QCOMPARE(layout->count(), 4);
+    QCOMPARE(cellOf(layout, a), QRect(0, 0, 1, 1));
+    QCOMPARE(cellOf(layout, b), QRect(2, 0, 1, 1));
+    QCOMPARE(cellOf(layout, c), QRect(0, 1, 3, 1));
+    QCOMPARE(cellOf(layout, d), QRect(0, 2, 1, 1));
+}
+
+void TestLayouts::linearLayoutMatchesBoxLayout_data()
+{
+    QTest::addColumn<QString>("fixture");
+    QTest::addColumn<bool>("vertical");
+
+    for (const char *fixture : { "preferred", "stretched", "expanding", "hidden", "spacers",
+                                 "defaultSpacing" }) {
+        QTest::newRow((QByteArray(fixture) + "/horizontal").constData())
+            << QString::fromLatin1(fixture) << false;
+        QTest::newRow((QByteArray(fixture) + "/vertical").constData())
+            << QString::fromLatin1(fixture) << true;
+    }
+}
+
+void TestLayouts::linearLayoutMatchesBoxLayout()
+{
+    QFETCH(QString, fixture);
+    QFETCH(bool, vertical);
+
+    const QBoxLayout::Direction direction = vertical ? QBoxLayout::TopToBottom
+                                                     : QBoxLayout::LeftToRight;
+    QWidget qtWindow;
+    QWidget cachedWindow;
+    auto qtBox = new QBoxLayout(direction, &qtWindow);
+    auto cachedBox = new LinearLayout(direction, &cachedWindow);
+    fillFixture(qtBox, fixture);
+    fillFixture(cachedBox, fixture);
+
+    QCOMPARE(cachedBox->minimumSize(), qtBox->minimumSize());
+    QCOMPARE(cachedBox->sizeHint(), qtBox->sizeHint());
+    QCOMPARE(cachedBox->maximumSize(), qtBox->maximumSize());
+    QCOMPARE(cachedBox->expandingDirections(), qtBox->expandingDirections());
+
+    // Only sizes from the minimum up are compared, LinearLayout deliberately
+    // shrinks differently below the minimum.
+    const QSize minimum = qtBox->minimumSize();
+    const QSize hint = qtBox->sizeHint();
+    const int from = vertical ? minimum.height() : minimum.width();
+    const int to = 2 * (vertical ? hint.height() : hint.width()) + 40;
+    for (int size = from; size <= to; size += 3) {
+        const QRect rect = vertical ? QRect(0, 0, 200, size) : QRect(0, 0, size, 200);
+        qtBox->setGeometry(rect);
+        cachedBox->setGeometry(rect);
+        for (int i = 0; i < qtBox->count(); ++i) {
+            QCOMPARE(cachedBox->itemAt(i)->geometry(), qtBox->itemAt(i)->geometry());
+        }
+    }
+}
+
+void TestLayouts::linearLayoutBelowMinimum()
+{
+    QWidget window;
+    auto box = new LinearLayout(QBoxLayout::LeftToRight, &window);
+    box->setContentsMargins(0, 0, 0, 0);
+    box->setSpacing(0);
+    auto small = new HintWidget(20, 50);
+    auto large = new HintWidget(40, 80);
+    box->addWidget(small);
+    box->addWidget(large);
+
+    // QBoxLayout takes the missing space from the largest items first (15
+    // and 15), LinearLayout shrinks all items by their minimum sizes.
+    box->setGeometry(QRect(0, 0, 30, 100));
+    QCOMPARE(box->itemAt(0)->geometry(), QRect(0, 0, 10, 100));
+    QCOMPARE(box->itemAt(1)->geometry(), QRect(10, 0, 20, 100));
+}
+
+void TestLayouts::breakpointTurnsSpacing()
+{
+    QWidget window;
+    auto a = new HintWidget(10, 20);
+    auto b = new HintWidget(10, 20);
+    auto c = new HintWidget(10, 20);
+    QBoxLayout *box = HBox(&window, Margins(0), Spacing(0))
+                      << a << Spacing(24) << b << Spacing(12) << c
+                      << Breakpoint(480, QBoxLayout::TopToBottom).setSpacing(3, 4);
+    window.resize(600, 400);
+    window.show();
+    box->activate();
+
+    // The Spacing at index 1 keeps its size, the one at index 3 is
+    // overridden below the width and restored above it.
+    QCOMPARE(box->itemAt(1)->sizeHint(), QSize(24, 0));
+    QCOMPARE(box->itemAt(1)->geometry().width(), 24);
+    QCOMPARE(box->itemAt(3)->geometry().width(), 12);
+
+    window.resize(300, 600);
+    QTRY_COMPARE(box->direction(), QBoxLayout::TopToBottom);
+    box->activate();
+    QCOMPARE(box->itemAt(1)->sizeHint(), QSize(0, 24));
+    QCOMPARE(box->itemAt(1)->geometry().height(), 24);
+    QCOMPARE(box->itemAt(3)->sizeHint(), QSize(0, 4));
+    QCOMPARE(box->itemAt(3)->geometry().height(), 4);
+
+    window.resize(600, 400);
+    QTRY_COMPARE(box->direction(), QBoxLayout::LeftToRight);
+    box->activate();
+    QCOMPARE(box->itemAt(1)->sizeHint(), QSize(24, 0));
+    QCOMPARE(box->itemAt(1)->geometry().width(), 24);
+    QCOMPARE(box->itemAt(3)->sizeHint(), QSize(12, 0));
+    QCOMPARE(box->itemAt(3)->geometry().width(), 12);
+}
+
+void TestLayouts::breakpointAttachesNestedBox()
+{
+    QWidget window;
+    window.resize(600, 400);
+    QWidget *a = named("a");
+    auto inner = new QHBoxLayout;
+    QBoxLayout *nested = HBox(Margins(0)) << a << named("b") << inner
+                         << Breakpoint(480, QBoxLayout::TopToBottom);
+
+    // A layout taken from the box before it has a widget is no longer
+    // watched and can be deleted.
+    QCOMPARE(nested->takeAt(2)->layout(), inner);
+    delete inner;
+
+    // The box is attached to the widget when its children are reparented.
+    VBox(&window) << nested;
+    QCOMPARE(a->parentWidget(), &window);
+    QCOMPARE(nested->direction(), QBoxLayout::LeftToRight);
+    window.show();
+    window.resize(300, 400);
+    QTRY_COMPARE(nested->direction(), QBoxLayout::TopToBottom);
+    window.resize(600, 400);
+    QTRY_COMPARE(nested->direction(), QBoxLayout::LeftToRight);
+}
+
+void TestLayouts::sizeGroupFollowsHints()
+{
+    QWidget window;
+    auto a = new HintWidget(10, 50);
+    auto b = new HintWidget(10, 80);
+    SizeGroup group;
+    QBoxLayout *top = VBox(&window)
+                      << (HBox() << Grouped(a, group) << new HintWidget(10, 20))
+                      << (HBox() << Grouped(b, group) << new HintWidget(10, 20));
+    auto first = static_cast<QBoxLayout *>(top->itemAt(0)->layout());
+    top->activate();
+
+    QCOMPARE(group.count(), 2);
+    QCOMPARE(group.sizeHint().width(), 80);
+    QCOMPARE(first->itemAt(0)->sizeHint().width(), 80);
+
+    // Activation invalidates the members, the group then recomputes only
+    // their own hints.
+    b->setHint(30);
+    top->activate();
+    QCOMPARE(group.sizeHint().width(), 50);
+    QCOMPARE(first->itemAt(0)->sizeHint().width(), 50);
+
+    a->setHint(20);
+    top->activate();
+    QCOMPARE(group.sizeHint().width(), 30);
+    QCOMPARE(first->itemAt(0)->sizeHint().width(), 30);
+}
+
+void TestLayouts::sizeGroupSkipsHiddenMembers()
+{
+    QWidget window;
+    auto a = new HintWidget(10, 50);
+    auto b = new HintWidget(10, 80);
+    SizeGroup group;
+    QBoxLayout *top = VBox(&window)
+                      << (HBox() << Grouped(a, group))
+                      << (HBox() << Grouped(b, group));
+    auto first = static_cast<QBoxLayout *>(top->itemAt(0)->layout());
+    top->activate();
+    QCOMPARE(group.sizeHint().width(), 80);
+
+    b->hide();
+    top->activate();
+    QCOMPARE(group.sizeHint().width(), 50);
+    QCOMPARE(first->itemAt(0)->sizeHint().width(), 50);
+
+    b->show();
+    top->activate();
+    QCOMPARE(group.sizeHint().width(), 80);
+    QCOMPARE(first->itemAt(0)->sizeHint().width(), 80);
+}
+
+void TestLayouts::sizeGroupDefersInvalidation()
+{
+    QWidget left;
+    QWidget right;
+    auto a = new HintWidget(10, 50);
+    auto b = new HintWidget(10, 80);
+    SizeGroup group;
+    QBoxLayout *leftBox = HBox(&left, Margins(0)) << Grouped(a, group);
+    QBoxLayout *rightBox = HBox(&right, Margins(0)) << Grouped(b, group);
+    leftBox->activate();
+    rightBox->activate();
+    QCOMPARE(leftBox->sizeHint().width(), 80);
+
+    // The largest hint changes while the right box computes its size, the
+    // left box is invalidated only after that pass.
+    b->setHint(30);
+    rightBox->activate();
+    QCOMPARE(group.sizeHint().width(), 50);
+    QCOMPARE(leftBox->sizeHint().width(), 80);
+    QTRY_COMPARE(leftBox->sizeHint().width(), 50);
+}
+
+void TestLayouts::constraintLayoutSizes()
+{
+    QWidget window;
+    auto a = new HintWidget(20, 50);
+    auto b = new HintWidget(10, 40);
+    auto layout = new ConstraintLayout(&window);
+    layout->setContentsMargins(1, 2, 3, 4);
+    layout->addWidget(a);
+    layout->addWidget(b);
+    const Constraint beside = layout->anchors(b).left == layout->anchors(a).right() + 6;
+    QVERIFY(layout->addConstraint(beside));
+
+    // The minimum size lays out the items at their minimum sizes.
+    QCOMPARE(layout->sizeHint(), QSize(50 + 6 + 40 + 4, 50 + 6));
+    QCOMPARE(layout->minimumSize(), QSize(20 + 6 + 10 + 4, 20 + 6));
+
+    layout->setGeometry(QRect(0, 0, 200, 100));
+    const QRect first = layout->itemAt(0)->geometry();
+    const QRect second = layout->itemAt(1)->geometry();
+    QCOMPARE(first.width(), 50);
+    QCOMPARE(second.width(), 40);
+    QCOMPARE(second.x() - first.x() - first.width(), 6);
+
+    // A changed size hint invalidates the cached size hint, the minimum
+    // size stays the same.
+    a->setHint(70);
+    QCOMPARE(layout->sizeHint(), QSize(70 + 6 + 40 + 4, 70 + 6));
+    QCOMPARE(layout->minimumSize(), QSize(20 + 6 + 10 + 4, 20 + 6));
+
+    QVERIFY(layout->removeConstraint(beside));
+    QVERIFY(!layout->removeConstraint(beside));
+    QCOMPARE(layout->sizeHint(), QSize(70 + 4, 70 + 6));
+    QCOMPARE(layout->minimumSize(), QSize(20 + 4, 20 + 6));
+}
+
+void TestLayouts::geometryBoxBelowSpacing()
+{
+    // Items without minimum sizes in a rectangle smaller than the spacing
+    // get empty cells, which still keep the spacing apart.
+    const auto box = GeometryBox(Qt::Horizontal, Margins(0), Spacing(10))
+                     << Hint(QSize(20, 20)) << Hint(QSize(30, 20)) << Hint(QSize(40, 20));
+    QRect rects[3];
+    box.layout(QRect(0, 0, 15, 20), rects);
+    QCOMPARE(rects[0], QRect(0, 0, 0, 20));
+    QCOMPARE(rects[1], QRect(10, 0, 0, 20));
+    QCOMPARE(rects[2], QRect(20, 0, 0, 20));
+
+    box.layout(QRect(0, 0, 0, 20), rects);
+    QCOMPARE(rects[2], QRect(20, 0, 0, 20));
+}
+
+void TestLayouts::flowDefaultSpacing()
+{
+    // The offscreen platform uses the Fusion style, which returns -1 for
+    // the layout spacing metrics.
+    QWidget window;
+    auto a = new HintWidget(10, 30);
+    auto b = new HintWidget(10, 30);
+    auto c = new HintWidget(10, 30);
+    FlowLayout *flow = Flow(&window) << a << b << c;
+    flow->setGeometry(QRect(0, 0, 1000, 100));
+
+    const int spacing = b->geometry().x() - a->geometry().right() - 1;
+    QVERIFY(spacing >= 0);
+    QCOMPARE(c->geometry().x() - b->geometry().right() - 1, spacing);
+    QCOMPARE(flow->heightForWidth(1000), 30);
+
+    // Three items do not fit next to each other without spacing.
+    QVERIFY(flow->heightForWidth(89) > 30);
+}
+
+void TestLayouts::flowStretchSkipsHiddenItems()
+{
+    QWidget window;
+    auto a = new HintWidget(10, 30);
+    auto hidden = new HintWidget(10, 30);
+    auto c = new HintWidget(10, 30);
+    FlowLayout *flow = Flow(&window, Margins(0), Spacing(0))
+                       << Stretched(a, 1) << Stretched(hidden, 1) << c;
+    hidden->hide();
+    flow->setGeometry(QRect(0, 0, 200, 100));
+
+    // The remaining width goes to the visible stretched item only.
+    QCOMPARE(a->geometry(), QRect(0, 0, 170, 30));
+    QCOMPARE(c->geometry(), QRect(170, 0, 30, 30));
+}
+
+void TestLayouts::formLabelsShareTexts()
+{
+    const int pooled = FormLabelItem::internedCount();
+    {
+        QWidget window;
+        auto left = new QWidget(&window);
+        auto right = new QWidget(&window);
+        auto first = Form(left);
+        auto second = Form(right);
+        first.setLightweightLabels(true)
+            << Row(QStringLiteral("Name"), new HintWidget(10, 20))
+            << Row(QStringLiteral("Age"), new HintWidget(10, 20));
+        second.setLightweightLabels(true)
+            << Row(QString::fromLatin1("Name"), new HintWidget(10, 20));
+        QCOMPARE(FormLabelItem::internedCount(), pooled + 2);
+
+        auto a = dynamic_cast<FormLabelItem *>(first->itemAt(0, QFormLayout::LabelRole));
+        auto b = dynamic_cast<FormLabelItem *>(second->itemAt(0, QFormLayout::LabelRole));
+        QVERIFY(a && b);
+        QCOMPARE(a->text().constData(), b->text().constData());
+
+        // Replacing the only lightweight "Age" label releases its text.
+        QVERIFY(first.label(1));
+        QCOMPARE(FormLabelItem::internedCount(), pooled + 1);
+    }
+    QCOMPARE(FormLabelItem::internedCount(), pooled);
+}
+
+void TestLayouts::batchedBoxMatchesBoxLayout()
+{
+    QWidget plainWindow;
+    auto plain = new QHBoxLayout(&plainWindow);
+    plain->addWidget(named("a"));
+    plain->addStretch(2);
+    plain->addWidget(named("b"), 1, Qt::AlignTop);
+    plain->addSpacing(7);
+    plain->addWidget(named("c"));
+    plain->addWidget(named("d"), 3);
+
+    // Batched and unbatched calls are mixed, also across a commit.
+    QWidget window;
+    auto box = HBox(&window);
+    box << named("a");
+    box.setBatched(true);
+    box << Stretch(2) << Aligned(named("b"), Qt::AlignTop, 1);
+    box.commit();
+    box << Spacing(7);
+    box.setBatched(false);
+    box << named("c") << Stretched(named("d"), 3);
+
+    QCOMPARE(describe(box), describe(plain));
+}
+
+void TestLayouts::reversedBoxMatchesBoxLayout()
+{
+    // Children added in reversed mode end up in front of the existing ones
+    // in reverse order, also when they are mixed with batched children.
+    QWidget plainWindow;
+    auto plain = new QVBoxLayout(&plainWindow);
+    plain->addWidget(named("d"), 0, Qt::AlignRight);
+    plain->addStretch(2);
+    plain->addWidget(named("c"), 1);
+    plain->addWidget(named("a"));
+    plain->addWidget(named("b"));
+    plain->addSpacing(5);
+    plain->addWidget(named("e"));
+
+    QWidget window;
+    auto box = VBox(&window);
+    box << named("a");
+    box.setBatched(true);
+    box << named("b");
+    box.setReversed(true);
+    box << Stretched(named("c"), 1) << Stretch(2) << Aligned(named("d"), Qt::AlignRight);
+    box.setReversed(false);
+    QVERIFY(box.isBatched());
+    box << Spacing(5) << named("e");
+
+    QCOMPARE(describe(box), describe(plain));
+
+    // Unbatched reversed wrappers give the same order.
+    QWidget unbatchedWindow;
+    auto unbatched = VBox(&unbatchedWindow);
+    unbatched << named("a") << named("b");
+    unbatched.setReversed(true);
+    unbatched << Stretched(named("c"), 1) << Stretch(2) << Aligned(named("d"), Qt::AlignRight);
+    unbatched.setReversed(false);
+    QVERIFY(!unbatched.isBatched());
+    unbatched << Spacing(5) << named("e");
+
+    QCOMPARE(describe(unbatched), describe(plain));
+}
+
+void TestLayouts::flatteningSplicesNestedBoxes()
+{
+    struct Restore
+    {
+        ~Restore() { Box::setFlatteningEnabled(false); }
+    } restore;
+    Box::setFlatteningEnabled(true);
+    const int flattened = Box::flattenedLayoutCount();
+
+    // A nested box in the same direction is spliced with the stretch
+    // factors, stretches and spacings of its items.
+    QWidget plainWindow;
+    auto plain = new QHBoxLayout(&plainWindow);
+    plain->addWidget(named("a"));
+    plain->addWidget(named("b"), 0, Qt::AlignTop);
+    plain->addStretch(3);
+    plain->addSpacing(5);
+    plain->addWidget(named("c"), 2);
+    plain->addWidget(named("d"));
+
+    QWidget window;
+    QBoxLayout *box = HBox(&window)
+                      << named("a")
+                      << (HBox() << Aligned(named("b"), Qt::AlignTop) << Stretch(3) << Spacing(5)
+                                 << Stretched(named("c"), 2))
+                      << named("d");
+    QCOMPARE(Box::flattenedLayoutCount(), flattened + 1);
+    QCOMPARE(describe(box), describe(plain));
+
+    // Boxes with margins, explicit spacing or another direction are kept.
+    QWidget keptWindow;
+    QBoxLayout *kept = HBox(&keptWindow)
+                       << (HBox(Margins(2)) << named("e"))
+                       << (HBox(Spacing(4)) << named("f"))
+                       << (VBox() << named("g") << named("h"));
+    QCOMPARE(Box::flattenedLayoutCount(), flattened + 1);
+    QCOMPARE(kept->count(), 3);
+    for (int i = 0; i < kept->count(); ++i) {
+        QVERIFY(kept->itemAt(i)->layout());
+    }
+    QCOMPARE(kept->itemAt(0)->layout()->contentsMargins(), QMargins(2, 2, 2, 2));
+    QCOMPARE(kept->itemAt(1)->layout()->spacing(), 4);
+    QCOMPARE(kept->itemAt(2)->layout()->count(), 2);
+}
+
+void TestLayouts::geometryCacheReplaysGeometries()
+{
+    struct Restore
+    {
+        ~Restore() { GeometryCache::setEnabled(false); }
+    } restore;
+    GeometryCache::setEnabled(true);
+    GeometryCache::resetCounters();
+
+    QWidget window;
+    auto a = new HintWidget(10, 20);
+    auto b = new HintWidget(10, 20);
+    auto c = new HintWidget(10, 20);
+    QBoxLayout *box = VBox(&window, Margins(0), Spacing(0))
+                      << a << (HBox(Spacing(4)) << b << Stretched(c, 1));
+    QLayout *nested = box->itemAt(1)->layout();
+    const auto geometries = [&] {
+        return QVector<QRect>{ a->geometry(), b->geometry(), c->geometry(), nested->geometry() };
+    };
+
+    const QRect small(0, 0, 100, 100);
+    const QRect large(0, 0, 300, 200);
+    box->setGeometry(small);
+    const QVector<QRect> expected = geometries();
+    box->setGeometry(large);
+    QVERIFY(geometries() != expected);
+    QCOMPARE(GeometryCache::missCount(), 2);
+    QCOMPARE(GeometryCache::hitCount(), 0);
+
+    // Resizing back to a remembered size replays the recorded geometries.
+    box->setGeometry(small);
+    QCOMPARE(GeometryCache::hitCount(), 1);
+    QCOMPARE(geometries(), expected);
+
+    // An invalidation drops the entries, the next pass is computed again.
+    box->invalidate();
+    box->setGeometry(large);
+    box->setGeometry(small);
+    QCOMPARE(GeometryCache::hitCount(), 1);
+    QCOMPARE(GeometryCache::missCount(), 4);
+    QCOMPARE(geometries(), expected);
+}
+
+void TestLayouts::resizeCoalescingAppliesLastRect()
+{
+    struct Restore
+    {
+        ~Restore()
+        {
+            ResizeCoalescing::setEnabled(false);
+            ResizeCoalescing::setFrameInterval(0);
+        }
+    } restore;
+    ResizeCoalescing::setEnabled(true);
+    ResizeCoalescing::setFrameInterval(500);
+
+    QWidget window;
+    window.resize(100, 100);
+    auto last = new HintWidget(10, 20);
+    QBoxLayout *box = VBox(&window, Margins(0), Spacing(0)) << new HintWidget(10, 20) << last;
+    box->activate();
+    ResizeCoalescing::resetCounters();
+
+    // Resizes within the frame interval after the activation are collapsed,
+    // only the last one is laid out when the interval elapses.
+    box->setGeometry(QRect(0, 0, 100, 200));
+    box->setGeometry(QRect(0, 0, 100, 300));
+    box->setGeometry(QRect(0, 0, 100, 400));
+    QCOMPARE(ResizeCoalescing::passCount(), 0);
+    QCOMPARE(ResizeCoalescing::collapsedCount(), 3);
+    QCOMPARE(box->geometry(), QRect(0, 0, 100, 100));
+
+    QTRY_COMPARE(box->geometry(), QRect(0, 0, 100, 400));
+    QCOMPARE(ResizeCoalescing::passCount(), 1);
+    QCOMPARE(last->geometry(), QRect(0, 200, 100, 200));
+
+    // A pass after an invalidation is never deferred.
+    box->invalidate();
+    box->setGeometry(QRect(0, 0, 100, 600));
+    QCOMPARE(ResizeCoalescing::passCount(), 2);
+    QCOMPARE(ResizeCoalescing::collapsedCount(), 3);
+    QCOMPARE(last->geometry(), QRect(0, 300, 100, 300));
+}
+
+void TestLayouts::styleMetricsFollowStyle()
+{
+    struct Restore
+    {
+        ~Restore() { StyleMetrics::setEnabled(false); }
+    } restore;
+    StyleMetrics::setEnabled(true);
+
+    // The styles are not owned by the widgets and must outlive them.
+    MetricStyle first(4);
+    MetricStyle second(9);
+    QWidget window;
+    window.setStyle(&first);
+    QBoxLayout *box = VBox(&window) << named("a") << (HBox() << named("b"));
+    QLayout *nested = box->itemAt(1)->layout();
+    QWidget explicitWindow;
+    explicitWindow.setStyle(&first);
+    QBoxLayout *explicitBox = VBox(&explicitWindow, Margins(2), Spacing(3))
+                              << (HBox(Spacing(1)) << named("c"));
+    QLayout *explicitNested = explicitBox->itemAt(0)->layout();
+
+    QCOMPARE(box->contentsMargins(), QMargins(4, 4, 4, 4));
+    QCOMPARE(box->spacing(), 4);
+    QCOMPARE(nested->spacing(), 4);
+
+    // A style change resolves the defaults again.
+    window.setStyle(&second);
+    explicitWindow.setStyle(&second);
+    QCOMPARE(box->contentsMargins(), QMargins(9, 9, 9, 9));
+    QCOMPARE(box->spacing(), 9);
+    QCOMPARE(nested->spacing(), 9);
+
+    // A change of the device pixel ratio arrives as a screen change.
+    second.setMetric(12);
+    QEvent screenChange(QEvent::ScreenChangeInternal);
+    QCoreApplication::sendEvent(&window, &screenChange);
+    QCoreApplication::sendEvent(&explicitWindow, &screenChange);
+    QCOMPARE(box->contentsMargins(), QMargins(12, 12, 12, 12));
+    QCOMPARE(box->spacing(), 12);
+    QCOMPARE(nested->spacing(), 12);
+
+    // Explicit values are never replaced.
+    QCOMPARE(explicitBox->contentsMargins(), QMargins(2, 2, 2, 2));
+    QCOMPARE(explicitBox->spacing(), 3);
+    QCOMPARE(explicitNested->spacing(), 1);
+}
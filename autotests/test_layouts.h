@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QObject>
+
+class TestLayouts : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void gridAutoPlacement();
+    void gridPlacementAcrossCommits();
+    void linearLayoutMatchesBoxLayout_data();
+    void linearLayoutMatchesBoxLayout();
+    void linearLayoutBelowMinimum();
+    void breakpointTurnsSpacing();
+    void breakpointAttachesNestedBox();
+    void sizeGroupFollowsHints();
+    void sizeGroupSkipsHiddenMembers();
+    void sizeGroupDefersInvalidation();
+    void constraintLayoutSizes();
+    void geometryBoxBelowSpacing();
+    void flowDefaultSpacing();
+    void flowStretchSkipsHiddenItems();
+    void formLabelsShareTexts();
+    void batchedBoxMatchesBoxLayout();
+    void reversedBoxMatchesBoxLayout();
+    void flatteningSplicesNestedBoxes();
+    void geometryCacheReplaysGeometries();
+    void resizeCoalescingAppliesLastRect();
+    void styleMetricsFollowStyle();
+};
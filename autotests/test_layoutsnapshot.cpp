@@ -0,0 +1,172 @@
+#include "test_layoutsnapshot.h"
+
+#include <QtTest>
+
+#include "qtutils/layoutsnapshot.h"
+
+/**
+ * @brief Returns a widget named by its ID, as both the recorded and the
+ * replayed widgets are.
+ */
+static QWidget *widgetFor(int id)
+{
+    auto widget = new QWidget();
+    widget->setObjectName(QString::number(id));
+    return widget;
+}
+
+/**
+ * @brief Builds the recorded hierarchy, with boxes in both directions,
+ * stretches, spacings, alignments and a form with label texts and widgets.
+ */
+static QBoxLayout *buildFixture(QWidget *parent)
+{
+    return VBox(parent, Margins(1, 2, 3, 4), Spacing(5))
+           << widgetFor(0) << Stretch(2)
+           << (HBox(Spacing(7)) << Stretched(widgetFor(1), 3) << Spacing(9)
+                                << Aligned(widgetFor(2), Qt::AlignTop))
+           << (Form() << Row(QStringLiteral("Name"), widgetFor(3))
+                      << Row(widgetFor(4), widgetFor(5)));
+}
+
+static QByteArray recordFixture()
+{
+    QWidget source;
+    return LayoutSnapshot::record(buildFixture(&source), [](QWidget *widget) {
+        bool ok = false;
+        const int id = widget->objectName().toInt(&ok);
+        return ok ? id : -1;
+    });
+}
+
+static QString describe(QLayoutItem *item);
+
+/**
+ * @brief Describes a layout hierarchy with the effective margins, spacings,
+ * stretch factors and alignments, and widgets by their names or label texts.
+ */
+static QString describe(QLayout *layout)
+{
+    const QMargins m = layout->contentsMargins();
+    const QString margins = QStringLiteral("[%1 %2 %3 %4]")
+                                .arg(m.left())
+                                .arg(m.top())
+                                .arg(m.right())
+                                .arg(m.bottom());
+    QString text;
+    if (auto box = qobject_cast<QBoxLayout *>(layout)) {
+        text = QStringLiteral("box %1 %2 %3 (")
+                   .arg(int(box->direction()))
+                   .arg(margins)
+                   .arg(box->spacing());
+        for (int i = 0; i < box->count(); ++i) {
+            text += QStringLiteral("%1/%2 ").arg(describe(box->itemAt(i))).arg(box->stretch(i));
+        }
+    } else if (auto form = qobject_cast<QFormLayout *>(layout)) {
+        text = QStringLiteral("form %1 %2 %3 (")
+                   .arg(margins)
+                   .arg(form->horizontalSpacing())
+                   .arg(form->verticalSpacing());
+        for (int row = 0; row < form->rowCount(); ++row) {
+            QLayoutItem *label = form->itemAt(row, QFormLayout::LabelRole);
+            QLayoutItem *field = form->itemAt(row, QFormLayout::FieldRole);
+            text += QStringLiteral("%1: %2 ")
+                        .arg(label ? describe(label) : QString())
+                        .arg(field ? describe(field) : QString());
+        }
+    }
+    return text + QLatin1Char(')');
+}
+
+static QString describe(QLayoutItem *item)
+{
+    if (QWidget *widget = item->widget()) {
+        auto label = qobject_cast<QLabel *>(widget);
+        const QString name = label && widget->objectName().isEmpty() ? label->text()
+                                                                     : widget->objectName();
+        return QStringLiteral("%1@%2").arg(name).arg(int(item->alignment()));
+    }
+    if (QLayout *layout = item->layout()) {
+        return describe(layout);
+    }
+    if (QSpacerItem *spacer = item->spacerItem()) {
+        const QSize size = spacer->sizeHint();
+        return QStringLiteral("spacer %1x%2").arg(size.width()).arg(size.height());
+    }
+    return QString();
+}
+
+/**
+ * @brief Returns a snapshot of boxes nested depth levels deep, built from
+ * the record of an empty box, whose last word is its item count.
+ */
+static QByteArray nested(int depth)
+{
+    QVBoxLayout empty;
+    const QByteArray snapshot = LayoutSnapshot::record(&empty, [](QWidget *) { return -1; });
+    const QByteArray leaf = snapshot.mid(4);
+    QByteArray parent = leaf;
+    const qint32 one = 1;
+    memcpy(parent.data() + parent.size() - 4, &one, sizeof(one));
+
+    QByteArray data = snapshot.left(4);
+    for (int i = 1; i < depth; ++i) {
+        data += parent;
+    }
+    return data + leaf;
+}
+
+void TestLayoutSnapshot::replayMatchesRecorded()
+{
+    QWidget source;
+    QBoxLayout *layout = buildFixture(&source);
+    const QByteArray snapshot = recordFixture();
+    QVERIFY(!snapshot.isEmpty());
+
+    QWidget target;
+    QLayout *replayed = LayoutSnapshot::replay(snapshot, widgetFor, &target);
+    QVERIFY(replayed);
+    QCOMPARE(target.layout(), replayed);
+    QCOMPARE(describe(replayed), describe(layout));
+}
+
+void TestLayoutSnapshot::rejectsMalformedData()
+{
+    const QByteArray snapshot = recordFixture();
+    QVector<QPointer<QWidget>> created;
+    const auto createWidget = [&created](int id) {
+        QWidget *widget = widgetFor(id);
+        created << widget;
+        return widget;
+    };
+
+    // Every truncated snapshot is rejected, and the widgets created until
+    // the end of the data are deleted.
+    for (int size = 0; size < snapshot.size(); size += 2) {
+        QVERIFY(!LayoutSnapshot::replay(snapshot.left(size), createWidget));
+    }
+    QVERIFY(!created.isEmpty());
+    for (const QPointer<QWidget> &widget : qAsConst(created)) {
+        QVERIFY(!widget);
+    }
+
+    // A wrong magic word, an invalid direction of the top level box and an
+    // unknown record of its first item.
+    for (int index : { 0, 2, 10 }) {
+        QByteArray garbage = snapshot;
+        const qint32 word = 1000;
+        memcpy(garbage.data() + index * 4, &word, sizeof(word));
+        QVERIFY(!LayoutSnapshot::replay(garbage, createWidget));
+    }
+    QVERIFY(!LayoutSnapshot::replay(QByteArray(64, '\xff'), createWidget));
+}
+
+void TestLayoutSnapshot::rejectsDeepNesting()
+{
+    const auto createWidget = [](int id) { return widgetFor(id); };
+
+    QWidget window;
+    QVERIFY(LayoutSnapshot::replay(nested(LayoutSnapshot::MaxDepth), createWidget, &window));
+    QVERIFY(!LayoutSnapshot::replay(nested(LayoutSnapshot::MaxDepth + 1), createWidget));
+    QVERIFY(!LayoutSnapshot::replay(nested(100000), createWidget));
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <QObject>
+
+class TestLayoutSnapshot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void replayMatchesRecorded();
+    void rejectsMalformedData();
+    void rejectsDeepNesting();
+};
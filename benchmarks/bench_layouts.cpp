@@ -0,0 +1,903 @@
+#include "bench_layouts.h"
+
+#include <QEventLoop>
+#include <QFrame>
+#include <QLabel>
+#include <QLineEdit>
+#include <QScrollArea>
+#include <QtTest>
+
+#include "qtutils/breakpoints.h"
+#include "qtutils/constraintlayout.h"
+#include "qtutils/flowlayout.h"
+#include "qtutils/geometrybox.h"
+#include "qtutils/incrementalbox.h"
+#include "qtutils/keyedbox.h"
+#include "qtutils/layouts.h"
+#include "qtutils/sizegroup.h"
+#include "qtutils/styleclasses.h"
+#include "qtutils/virtualform.h"
+
+static int layoutCount(QLayout *layout)
+{
+    int count = 1;
+    for (int i = 0; i < layout->count(); ++i) {
+        if (QLayout *child = layout->itemAt(i)->layout()) {
+            count += layoutCount(child);
+        }
+    }
+    return count;
+}
+
+void BenchLayouts::boxConstruction_data()
+{
+    QTest::addColumn<int>("children");
+    QTest::addColumn<bool>("batched");
+
+    for (int children : { 100, 1000, 10000 }) {
+        const QByteArray count = QByteArray::number(children);
+        QTest::newRow((count + "/immediate").constData()) << children << false;
+        QTest::newRow((count + "/batched").constData()) << children << true;
+    }
+}
+
+void BenchLayouts::boxConstruction()
+{
+    QFETCH(int, children);
+    QFETCH(bool, batched);
+
+    QBENCHMARK {
+        QWidget window;
+        auto box = VBox(&window).setBatched(batched);
+        for (int i = 0; i < children; ++i) {
+            box << new QWidget() << Spacing(2);
+        }
+        box.commit();
+    }
+}
+
+void BenchLayouts::reversedBoxConstruction_data()
+{
+    QTest::addColumn<int>("children");
+    QTest::addColumn<bool>("reversed");
+
+    for (int children : { 1000, 10000, 50000 }) {
+        const QByteArray count = QByteArray::number(children);
+        QTest::newRow((count + "/forward").constData()) << children << false;
+        QTest::newRow((count + "/reversed").constData()) << children << true;
+    }
+}
+
+void BenchLayouts::reversedBoxConstruction()
+{
+    QFETCH(int, children);
+    QFETCH(bool, reversed);
+
+    QBENCHMARK {
+        QWidget window;
+        auto box = HBox(&window).setReversed(reversed);
+        for (int i = 0; i < children; ++i) {
+            box << new QWidget();
+        }
+        box.commit();
+    }
+}
+
+void BenchLayouts::gridGeometry_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<bool>("nested");
+
+    for (int rows : { 10, 100, 500 }) {
+        const QByteArray count = QByteArray::number(rows);
+        QTest::newRow((count + "/nested").constData()) << rows << true;
+        QTest::newRow((count + "/grid").constData()) << rows << false;
+    }
+}
+
+void BenchLayouts::gridGeometry()
+{
+    QFETCH(int, rows);
+    QFETCH(bool, nested);
+
+    // Data entry grid with two label and edit pairs per row.
+    const int columns = 4;
+    QWidget window;
+    if (nested) {
+        auto box = VBox(&window);
+        for (int row = 0; row < rows; ++row) {
+            auto line = HBox();
+            for (int column = 0; column < columns; column += 2) {
+                line << new QLabel(QStringLiteral("Label")) << new QLineEdit();
+            }
+            box << line;
+        }
+    } else {
+        auto grid = Grid(&window).setColumns(columns);
+        for (int row = 0; row < rows; ++row) {
+            for (int column = 0; column < columns; column += 2) {
+                grid << new QLabel(QStringLiteral("Label")) << new QLineEdit();
+            }
+        }
+    }
+
+    QLayout *layout = window.layout();
+    qInfo("%d layout objects", layoutCount(layout));
+
+    const QSize sizes[] = { QSize(400, 300), QSize(800, 600) };
+    int pass = 0;
+    QBENCHMARK {
+        window.resize(sizes[pass++ % 2]);
+        layout->invalidate();
+        layout->activate();
+    }
+}
+
+void BenchLayouts::formConstruction_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<bool>("lightweight");
+
+    for (int rows : { 100, 1000 }) {
+        const QByteArray count = QByteArray::number(rows);
+        QTest::newRow((count + "/labels").constData()) << rows << false;
+        QTest::newRow((count + "/lightweight").constData()) << rows << true;
+    }
+}
+
+void BenchLayouts::formConstruction()
+{
+    QFETCH(int, rows);
+    QFETCH(bool, lightweight);
+
+    int widgets = 0;
+    QBENCHMARK {
+        QWidget window;
+        auto form = Form(&window, Margins()).setLightweightLabels(lightweight);
+        for (int row = 0; row < rows; ++row) {
+            form << Row(QStringLiteral("Label"),
+                        HBox() << new QLineEdit() << Stretched(new QLineEdit(), 2));
+        }
+        widgets = window.findChildren<QWidget *>().size();
+    }
+    qInfo("widgets: %d", widgets);
+}
+
+void BenchLayouts::boxResize_data()
+{
+    QTest::addColumn<int>("children");
+    QTest::addColumn<bool>("caching");
+
+    for (int children : { 50, 500 }) {
+        const QByteArray count = QByteArray::number(children);
+        QTest::newRow((count + "/qt").constData()) << children << false;
+        QTest::newRow((count + "/caching").constData()) << children << true;
+    }
+}
+
+void BenchLayouts::boxResize()
+{
+    QFETCH(int, children);
+    QFETCH(bool, caching);
+
+    Box::setDefaultEngine(caching ? Box::Engine::Caching : Box::Engine::Qt);
+    QWidget window;
+    auto box = VBox(&window, Margins(), Spacing(4));
+    for (int i = 0; i < children; ++i) {
+        box << new QLabel(QStringLiteral("Label")) << Stretched(new QLineEdit(), i % 3);
+    }
+    Box::setDefaultEngine(Box::Engine::Qt);
+
+    // Interactive resize only sets the geometry of the top-level layout,
+    // without invalidating it.
+    QLayout *layout = window.layout();
+    layout->activate();
+    int height = children * 40;
+    QBENCHMARK {
+        layout->setGeometry(QRect(0, 0, 400, ++height));
+    }
+}
+
+void BenchLayouts::profiledResize_data()
+{
+    QTest::addColumn<bool>("profiled");
+
+    QTest::newRow("plain") << false;
+    QTest::newRow("profiled") << true;
+}
+
+void BenchLayouts::profiledResize()
+{
+    QFETCH(bool, profiled);
+
+    LayoutProfiler::setEnabled(profiled);
+    QWidget window;
+    auto box = VBox(&window, Margins(), Spacing(4));
+    for (int i = 0; i < 50; ++i) {
+        box << (HBox() << new QLabel(QStringLiteral("Label")) << new QLineEdit());
+    }
+    LayoutProfiler::setEnabled(false);
+
+    QLayout *layout = window.layout();
+    layout->activate();
+    int height = 2000;
+    QBENCHMARK {
+        layout->setGeometry(QRect(0, 0, 400, ++height));
+    }
+    if (profiled) {
+        LayoutProfiler::dump();
+        LayoutProfiler::reset();
+    }
+}
+
+void BenchLayouts::incrementalConstruction_data()
+{
+    QTest::addColumn<int>("children");
+
+    for (int children : { 1000, 10000 }) {
+        QTest::newRow(QByteArray::number(children).constData()) << children;
+    }
+}
+
+void BenchLayouts::incrementalConstruction()
+{
+    QFETCH(int, children);
+
+    int chunks = 0;
+    QBENCHMARK {
+        QWidget window;
+        IncrementalBox builder{ VBox(&window) };
+        for (int i = 0; i < children; ++i) {
+            builder << new QWidget() << Spacing(2);
+        }
+        chunks = 0;
+        QEventLoop loop;
+        connect(&builder, &IncrementalBox::progress, [&chunks] { ++chunks; });
+        connect(&builder, &IncrementalBox::finished, &loop, &QEventLoop::quit);
+        builder.start();
+        loop.exec();
+    }
+    qInfo("chunks: %d", chunks);
+}
+
+void BenchLayouts::keyedUpdate_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<bool>("keyed");
+
+    for (int rows : { 100, 1000 }) {
+        const QByteArray count = QByteArray::number(rows);
+        QTest::newRow((count + "/rebuild").constData()) << rows << false;
+        QTest::newRow((count + "/keyed").constData()) << rows << true;
+    }
+}
+
+void BenchLayouts::keyedUpdate()
+{
+    QFETCH(int, rows);
+    QFETCH(bool, keyed);
+
+    // Each update moves one row to the end of the panel.
+    QStringList keys;
+    for (int row = 0; row < rows; ++row) {
+        keys << QString::number(row);
+    }
+
+    QWidget window;
+    if (keyed) {
+        KeyedBox panel{ VBox(&window) };
+        QBENCHMARK {
+            keys.append(keys.takeFirst());
+            QVector<Keyed> items;
+            items.reserve(keys.size());
+            for (const QString &key : qAsConst(keys)) {
+                items << Keyed(key, [] { return new QLineEdit(); });
+            }
+            panel.apply(items);
+        }
+    } else {
+        QBENCHMARK {
+            keys.append(keys.takeFirst());
+            delete window.layout();
+            qDeleteAll(window.findChildren<QWidget *>(QString(), Qt::FindDirectChildrenOnly));
+            auto box = VBox(&window);
+            for (int row = 0; row < keys.size(); ++row) {
+                box << new QLineEdit();
+            }
+        }
+    }
+}
+
+void BenchLayouts::virtualForm_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<bool>("virtualized");
+
+    for (int rows : { 1000, 5000 }) {
+        const QByteArray count = QByteArray::number(rows);
+        QTest::newRow((count + "/Form").constData()) << rows << false;
+        QTest::newRow((count + "/VirtualForm").constData()) << rows << true;
+    }
+}
+
+void BenchLayouts::virtualForm()
+{
+    QFETCH(int, rows);
+    QFETCH(bool, virtualized);
+
+    const QString label = QStringLiteral("Property");
+    int widgets = 0;
+    QBENCHMARK {
+        if (virtualized) {
+            VirtualForm form(
+                rows, [] { return new QLineEdit(); },
+                [&label](int row, QLabel *rowLabel, QWidget *field) {
+                    rowLabel->setText(label);
+                    static_cast<QLineEdit *>(field)->setText(QString::number(row));
+                });
+            form.resize(400, 600);
+            form.show();
+            widgets = form.findChildren<QWidget *>().size();
+        } else {
+            QScrollArea area;
+            auto content = new QWidget();
+            auto form = Form(content);
+            for (int row = 0; row < rows; ++row) {
+                auto field = new QLineEdit(QString::number(row));
+                form << Row(label, field);
+            }
+            area.setWidget(content);
+            area.resize(400, 600);
+            area.show();
+            widgets = area.findChildren<QWidget *>().size();
+        }
+    }
+    qInfo("widgets: %d", widgets);
+}
+
+void BenchLayouts::flowResize_data()
+{
+    QTest::addColumn<int>("children");
+
+    for (int children : { 100, 1000 }) {
+        QTest::newRow(QByteArray::number(children).constData()) << children;
+    }
+}
+
+void BenchLayouts::flowResize()
+{
+    QFETCH(int, children);
+
+    QWidget window;
+    auto flow = Flow(&window, Margins(), Spacing(4));
+    for (int i = 0; i < children; ++i) {
+        flow << new QLabel(QStringLiteral("Tag %1").arg(i));
+    }
+
+    // An interactive resize queries the height for a few widths around the
+    // current one and then sets the geometry.
+    QLayout *layout = window.layout();
+    layout->activate();
+    int width = 300;
+    QBENCHMARK {
+        width = width < 900 ? width + 1 : 300;
+        for (int delta = -2; delta <= 2; ++delta) {
+            layout->heightForWidth(width + delta);
+        }
+        layout->setGeometry(QRect(0, 0, width, layout->heightForWidth(width)));
+    }
+}
+
+void BenchLayouts::geometryResize_data()
+{
+    QTest::addColumn<int>("children");
+    QTest::addColumn<bool>("widgets");
+
+    for (int children : { 50, 500 }) {
+        const QByteArray count = QByteArray::number(children);
+        QTest::newRow((count + "/widgets").constData()) << children << true;
+        QTest::newRow((count + "/geometry").constData()) << children << false;
+    }
+}
+
+void BenchLayouts::geometryResize()
+{
+    QFETCH(int, children);
+    QFETCH(bool, widgets);
+
+    // The same rows as in boxResize, described by the size hints of the
+    // widgets for the geometry engine.
+    QWidget window;
+    auto box = VBox(&window, Margins(0), Spacing(4));
+    auto geometry = GeometryBox(Qt::Vertical, Margins(0), Spacing(4));
+    for (int i = 0; i < children; ++i) {
+        auto label = new QLabel(QStringLiteral("Label"));
+        auto edit = new QLineEdit();
+        box << label << Stretched(edit, i % 3);
+        geometry << Hint(label->sizeHint(), 0, {}, label->minimumSizeHint())
+                 << Hint(edit->sizeHint(), i % 3, {}, edit->minimumSizeHint());
+    }
+
+    QLayout *layout = window.layout();
+    layout->activate();
+    QVector<QRect> rects(geometry.count());
+    int height = children * 40;
+    if (widgets) {
+        QBENCHMARK {
+            layout->setGeometry(QRect(0, 0, 400, ++height));
+        }
+    } else {
+        QBENCHMARK {
+            geometry.layout(QRect(0, 0, 400, ++height), rects.data());
+        }
+    }
+}
+
+void BenchLayouts::cachedResize_data()
+{
+    QTest::addColumn<bool>("cached");
+
+    QTest::newRow("computed") << false;
+    QTest::newRow("cached") << true;
+}
+
+void BenchLayouts::cachedResize()
+{
+    QFETCH(bool, cached);
+
+    GeometryCache::setEnabled(cached);
+    QWidget window;
+    auto box = VBox(&window, Margins(), Spacing(4));
+    for (int i = 0; i < 50; ++i) {
+        box << (HBox() << new QLabel(QStringLiteral("Label")) << Stretched(new QLineEdit(), 1));
+    }
+    GeometryCache::setEnabled(false);
+
+    // Toggles between a few window sizes, like maximizing and restoring.
+    const QRect sizes[] = { QRect(0, 0, 400, 2000), QRect(0, 0, 800, 2400), QRect(0, 0, 600, 2200) };
+    QLayout *layout = window.layout();
+    layout->activate();
+    GeometryCache::resetCounters();
+    int i = 0;
+    QBENCHMARK {
+        layout->setGeometry(sizes[i++ % 3]);
+    }
+    if (cached) {
+        qInfo("%d hits, %d misses", GeometryCache::hitCount(), GeometryCache::missCount());
+    }
+}
+
+void BenchLayouts::coalescedResize_data()
+{
+    QTest::addColumn<bool>("coalescing");
+
+    QTest::newRow("plain") << false;
+    QTest::newRow("coalescing") << true;
+}
+
+void BenchLayouts::coalescedResize()
+{
+    QFETCH(bool, coalescing);
+
+    ResizeCoalescing::setEnabled(coalescing);
+    QWidget window;
+    auto box = VBox(&window, Margins(), Spacing(4));
+    for (int i = 0; i < 50; ++i) {
+        box << (HBox() << new QLabel(QStringLiteral("Label")) << Stretched(new QLineEdit(), 1));
+    }
+    ResizeCoalescing::setEnabled(false);
+
+    // A window drag delivers a burst of resizes, many within one frame.
+    QLayout *layout = window.layout();
+    layout->activate();
+    ResizeCoalescing::resetCounters();
+    int width = 400;
+    QBENCHMARK {
+        for (int i = 0; i < 20; ++i) {
+            layout->setGeometry(QRect(0, 0, ++width, 2000));
+        }
+    }
+
+    if (coalescing) {
+        // The final pass is done when the frame interval elapses.
+        const int interval = ResizeCoalescing::frameInterval(&window);
+        QTest::qWait(2 * interval);
+        qInfo("frame interval %d ms, %d passes, %d collapsed, final width %d", interval,
+              ResizeCoalescing::passCount(), ResizeCoalescing::collapsedCount(),
+              layout->geometry().width());
+    }
+}
+
+void BenchLayouts::tabsConstruction_data()
+{
+    QTest::addColumn<bool>("lazy");
+
+    QTest::newRow("eager") << false;
+    QTest::newRow("lazy") << true;
+}
+
+void BenchLayouts::tabsConstruction()
+{
+    QFETCH(bool, lazy);
+
+    // A settings dialog with ten pages of fifty rows each.
+    const auto createPage = [] {
+        auto page = new QWidget();
+        auto form = Form(page);
+        for (int row = 0; row < 50; ++row) {
+            form << Row(QStringLiteral("Setting"), new QLineEdit());
+        }
+        return page;
+    };
+
+    int widgets = 0;
+    QBENCHMARK {
+        QWidget dialog;
+        auto tabs = Tabs();
+        for (int i = 0; i < 10; ++i) {
+            const QString title = QStringLiteral("Page %1").arg(i);
+            if (lazy) {
+                tabs << Tab(title, Lazy<QWidget>(createPage));
+            } else {
+                tabs << Tab(title, createPage());
+            }
+        }
+        VBox(&dialog) << tabs;
+        dialog.show();
+        widgets = dialog.findChildren<QWidget *>().size();
+    }
+    qInfo("widgets: %d", widgets);
+}
+
+void BenchLayouts::styleMetrics_data()
+{
+    QTest::addColumn<bool>("resolved");
+
+    QTest::newRow("style") << false;
+    QTest::newRow("resolved") << true;
+}
+
+void BenchLayouts::styleMetrics()
+{
+    QFETCH(bool, resolved);
+
+    // Default margins and spacing everywhere, three levels deep.
+    StyleMetrics::setEnabled(resolved);
+    QWidget window;
+    auto box = VBox(&window, Margins(), Spacing());
+    for (int i = 0; i < 20; ++i) {
+        auto row = HBox(Spacing());
+        for (int j = 0; j < 5; ++j) {
+            row << (VBox(Spacing()) << new QLabel(QStringLiteral("Label")) << new QLineEdit());
+        }
+        box << row;
+    }
+    StyleMetrics::setEnabled(false);
+
+    // A full layout pass, like after a change of a widget's size hint.
+    QLayout *layout = window.layout();
+    int width = 600;
+    QBENCHMARK {
+        layout->invalidate();
+        layout->activate();
+        layout->setGeometry(QRect(0, 0, ++width, 2000));
+    }
+    if (resolved) {
+        qInfo("style queries: %d", StyleMetrics::styleQueryCount());
+    }
+}
+
+void BenchLayouts::builtConstruction_data()
+{
+    QTest::addColumn<bool>("built");
+
+    QTest::newRow("configured") << false;
+    QTest::newRow("built") << true;
+}
+
+void BenchLayouts::builtConstruction()
+{
+    QFETCH(bool, built);
+
+    QBENCHMARK {
+        QWidget dialog;
+        auto form = Form(&dialog, Margins());
+        if (built) {
+            for (int i = 0; i < 100; ++i) {
+                form << Row(QStringLiteral("Setting"),
+                            Build<QLineEdit>()
+                                .set(&QLineEdit::setText, QString::number(i))
+                                .set(&QLineEdit::setPlaceholderText, QStringLiteral("Value"))
+                                .set(&QLineEdit::setMaxLength, 40)
+                                .set(&QWidget::setMinimumWidth, 100));
+            }
+        } else {
+            // The usual code, which configures the widgets after they are
+            // inserted.
+            for (int i = 0; i < 100; ++i) {
+                auto edit = new QLineEdit();
+                form << Row(QStringLiteral("Setting"), edit);
+                edit->setText(QString::number(i));
+                edit->setPlaceholderText(QStringLiteral("Value"));
+                edit->setMaxLength(40);
+                edit->setMinimumWidth(100);
+            }
+        }
+        dialog.show();
+        QCoreApplication::sendPostedEvents();
+    }
+}
+
+void BenchLayouts::styledFrames_data()
+{
+    QTest::addColumn<bool>("classes");
+
+    QTest::newRow("setStyleSheet") << false;
+    QTest::newRow("styleClass") << true;
+}
+
+void BenchLayouts::styledFrames()
+{
+    QFETCH(bool, classes);
+
+    StyleClasses::define("frame", "background: gray;");
+    QBENCHMARK {
+        QWidget window;
+        auto box = VBox(&window).setBatched(true);
+        for (int i = 0; i < 10000; ++i) {
+            auto frame = new QFrame();
+            if (classes) {
+                box << Styled(frame, "frame");
+            } else {
+                frame->setStyleSheet("background: gray;");
+                box << frame;
+            }
+        }
+        box.commit();
+        window.show();
+    }
+    StyleClasses::clear();
+}
+
+void BenchLayouts::breakpointResize_data()
+{
+    QTest::addColumn<bool>("breakpoint");
+
+    QTest::newRow("rebuilt") << false;
+    QTest::newRow("breakpoint") << true;
+}
+
+void BenchLayouts::breakpointResize()
+{
+    QFETCH(bool, breakpoint);
+
+    // A toolbar which is laid out in a column below 480 pixels, toggled
+    // across the breakpoint by resizes of its window.
+    QWidget window;
+    QVector<QWidget *> buttons;
+    for (int i = 0; i < 20; ++i) {
+        buttons.append(new QLabel(QStringLiteral("Button")));
+    }
+    auto build = [&window, &buttons](QBoxLayout::Direction direction) {
+        auto box = Box(new QBoxLayout(direction, &window), Margins(), Spacing());
+        for (QWidget *button : buttons) {
+            box << button << Spacing(8);
+        }
+        box << Stretch();
+        return box;
+    };
+    auto box = build(QBoxLayout::LeftToRight);
+    if (breakpoint) {
+        box << Breakpoint(480, QBoxLayout::TopToBottom);
+    }
+    window.resize(800, 800);
+    window.show();
+    QCoreApplication::sendPostedEvents();
+
+    Breakpoints::resetCounters();
+    bool narrow = false;
+    QBENCHMARK {
+        narrow = !narrow;
+        if (!breakpoint) {
+            delete window.layout();
+            build(narrow ? QBoxLayout::TopToBottom : QBoxLayout::LeftToRight);
+        }
+        window.resize(narrow ? 400 : 800, 800);
+        QCoreApplication::sendPostedEvents();
+    }
+    if (breakpoint) {
+        qInfo("%d switches", Breakpoints::switchCount());
+    }
+}
+
+void BenchLayouts::sizeGroupUpdate_data()
+{
+    QTest::addColumn<bool>("grouped");
+
+    QTest::newRow("rescan") << false;
+    QTest::newRow("sizeGroup") << true;
+}
+
+void BenchLayouts::sizeGroupUpdate()
+{
+    QFETCH(bool, grouped);
+
+    // Label columns of 50 separate forms aligned to the widest label, one
+    // label changing its text.
+    QWidget window;
+    auto box = VBox(&window);
+    SizeGroup group;
+    QVector<QLabel *> labels;
+    for (int i = 0; i < 50; ++i) {
+        auto form = Form();
+        if (grouped) {
+            form.setLabelGroup(group);
+        }
+        for (int j = 0; j < 10; ++j) {
+            auto label = new QLabel(QStringLiteral("Label %1").arg(j));
+            labels.append(label);
+            form << Row(label, new QLineEdit());
+        }
+        box << form;
+    }
+    auto align = [&labels] {
+        // The usual code, which rescans all labels for the widest one.
+        int width = 0;
+        for (QLabel *label : qAsConst(labels)) {
+            label->setMinimumWidth(0);
+            width = qMax(width, label->sizeHint().width());
+        }
+        for (QLabel *label : qAsConst(labels)) {
+            label->setMinimumWidth(width);
+        }
+    };
+    if (!grouped) {
+        align();
+    }
+    window.show();
+    QCoreApplication::sendPostedEvents();
+
+    SizeGroup::resetCounters();
+    QLabel *changed = labels.at(labels.size() / 2);
+    bool wide = false;
+    QBENCHMARK {
+        wide = !wide;
+        changed->setText(wide ? QStringLiteral("A much wider label") : QStringLiteral("Label"));
+        if (!grouped) {
+            align();
+        }
+        QCoreApplication::sendPostedEvents();
+    }
+    if (grouped) {
+        qInfo("%d member updates", SizeGroup::memberUpdateCount());
+    }
+}
+
+/**
+ * @brief Constraints of a grid of rows x columns cells, aligned in columns
+ * and flowing in rows, about ten per cell.
+ */
+static QVector<Constraint> gridConstraints(const QVector<ConstraintLayout::Anchors> &cells,
+                                           const ConstraintLayout::Anchors &contents,
+                                           int columns)
+{
+    QVector<Constraint> constraints;
+    for (int i = 0; i < cells.size(); ++i) {
+        const int row = i / columns;
+        const int column = i % columns;
+        const ConstraintLayout::Anchors &a = cells.at(i);
+        constraints << (a.width >= 20) << ((a.width == 60 + (i * 7) % 40) | Strength::Medium)
+                    << (a.height >= 20) << ((a.height == 24) | Strength::Medium)
+                    << (a.left >= 0) << (a.top >= 0)
+                    << ((a.right() <= contents.width) | Strength::Strong)
+                    << ((a.bottom() <= contents.height) | Strength::Strong);
+        if (column > 0) {
+            const ConstraintLayout::Anchors &left = cells.at(i - 1);
+            constraints << (a.left >= left.right() + 6) << (a.top == left.top);
+        }
+        if (row > 0) {
+            const ConstraintLayout::Anchors &above = cells.at(i - columns);
+            constraints << ((a.left == above.left) | Strength::Strong)
+                        << (a.top >= above.bottom() + 6);
+        }
+    }
+    constraints << (contents.width >= 0) << (contents.height >= 0)
+                << ((contents.width == 0) | Strength::Weak)
+                << ((contents.height == 0) | Strength::Weak);
+    return constraints;
+}
+
+void BenchLayouts::constraintSolve_data()
+{
+    QTest::addColumn<bool>("incremental");
+    QTest::addColumn<bool>("edit");
+
+    QTest::newRow("resize/scratch") << false << false;
+    QTest::newRow("resize/incremental") << true << false;
+    QTest::newRow("edit/scratch") << false << true;
+    QTest::newRow("edit/incremental") << true << true;
+}
+
+void BenchLayouts::constraintSolve()
+{
+    QFETCH(bool, incremental);
+    QFETCH(bool, edit);
+
+    // About 1000 constraints of a 10 x 9 grid. A resize suggests a new
+    // contents size, an edit replaces the preferred width of one cell.
+    const int columns = 10;
+    QVector<ConstraintLayout::Anchors> cells(90);
+    const ConstraintLayout::Anchors contents;
+    QVector<Constraint> constraints = gridConstraints(cells, contents, columns);
+    const int edited = 1; // The preferred width of the first cell.
+
+    auto solve = [&constraints, &contents](ConstraintSolver &solver, int width) {
+        for (const Constraint &constraint : qAsConst(constraints)) {
+            solver.addConstraint(constraint);
+        }
+        solver.addEditVariable(contents.width, Strength::Strong);
+        solver.addEditVariable(contents.height, Strength::Strong);
+        solver.suggestValue(contents.width, width);
+        solver.suggestValue(contents.height, 400);
+        solver.updateVariables();
+    };
+
+    ConstraintSolver solver;
+    solve(solver, 800);
+    const int pivots = solver.pivotCount();
+    int i = 0;
+    QBENCHMARK {
+        ++i;
+        if (edit) {
+            const Constraint constraint = (cells.at(0).width == 40 + i % 40) | Strength::Medium;
+            if (incremental) {
+                solver.removeConstraint(constraints.at(edited));
+                solver.addConstraint(constraint);
+                solver.updateVariables();
+            }
+            constraints[edited] = constraint;
+        }
+        if (!incremental) {
+            ConstraintSolver scratch;
+            solve(scratch, 800 + i % 200);
+        } else if (!edit) {
+            solver.suggestValue(contents.width, 800 + i % 200);
+            solver.updateVariables();
+        }
+    }
+    if (incremental) {
+        qInfo("%d constraints, %d pivots", solver.constraintCount(), solver.pivotCount() - pivots);
+    }
+}
+
+void BenchLayouts::constraintResize()
+{
+    // The grid of constraintSolve laid out by the Constraints wrapper.
+    QWidget window;
+    auto c = Constraints(&window);
+    QVector<QWidget *> labels;
+    for (int i = 0; i < 90; ++i) {
+        auto label = new QLabel(QStringLiteral("Label %1").arg(i));
+        labels.append(label);
+        c << label;
+    }
+    for (int i = 0; i < labels.size(); ++i) {
+        const ConstraintLayout::Anchors &a = c.anchors(labels.at(i));
+        if (i % 10 > 0) {
+            const ConstraintLayout::Anchors &left = c.anchors(labels.at(i - 1));
+            c << (a.left >= left.right() + 6) << (a.top == left.top);
+        }
+        if (i >= 10) {
+            const ConstraintLayout::Anchors &above = c.anchors(labels.at(i - 10));
+            c << ((a.left == above.left) | Strength::Strong) << (a.top >= above.bottom() + 6);
+        }
+    }
+
+    QLayout *layout = window.layout();
+    layout->activate();
+    int width = 800;
+    QBENCHMARK {
+        layout->setGeometry(QRect(0, 0, 800 + ++width % 200, 600));
+    }
+    qInfo("%d constraints", c->solver().constraintCount());
+}
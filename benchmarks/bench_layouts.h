@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QObject>
+
+class BenchLayouts : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void boxConstruction_data();
+    void boxConstruction();
+    void reversedBoxConstruction_data();
+    void reversedBoxConstruction();
+    void gridGeometry_data();
+    void gridGeometry();
+    void formConstruction_data();
+    void formConstruction();
+    void boxResize_data();
+    void boxResize();
+    void profiledResize_data();
+    void profiledResize();
+    void incrementalConstruction_data();
+    void incrementalConstruction();
+    void keyedUpdate_data();
+    void keyedUpdate();
+    void virtualForm_data();
+    void virtualForm();
+    void flowResize_data();
+    void flowResize();
+    void geometryResize_data();
+    void geometryResize();
+    void cachedResize_data();
+    void cachedResize();
+    void coalescedResize_data();
+    void coalescedResize();
+    void tabsConstruction_data();
+    void tabsConstruction();
+    void styleMetrics_data();
+    void styleMetrics();
+    void builtConstruction_data();
+    void builtConstruction();
+    void styledFrames_data();
+    void styledFrames();
+    void breakpointResize_data();
+    void breakpointResize();
+    void sizeGroupUpdate_data();
+    void sizeGroupUpdate();
+    void constraintSolve_data();
+    void constraintSolve();
+    void constraintResize();
+};
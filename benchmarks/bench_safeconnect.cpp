@@ -0,0 +1,37 @@
+#include "bench_safeconnect.h"
+
+#include <QtTest>
+
+#include "qtutils/safeconnect.h"
+
+void BenchSafeConnect::connectDisconnect_data()
+{
+    QTest::addColumn<int>("receivers");
+
+    for (int receivers : { 100, 1000, 10000 }) {
+        QTest::newRow(QByteArray::number(receivers).constData()) << receivers;
+    }
+}
+
+void BenchSafeConnect::connectDisconnect()
+{
+    QFETCH(int, receivers);
+
+    // All receivers are connected to the same sender, which is the worst case
+    // for the uniqueness check done by every safeConnect().
+    QObject sender;
+    QVector<QObject *> objects;
+    objects.reserve(receivers);
+    for (int i = 0; i < receivers; ++i) {
+        objects.append(new QObject(&sender));
+    }
+
+    QBENCHMARK {
+        for (QObject *receiver : qAsConst(objects)) {
+            safeConnect(&sender, &QObject::objectNameChanged, receiver, &QObject::deleteLater);
+        }
+        for (QObject *receiver : qAsConst(objects)) {
+            safeDisconnect(&sender, &QObject::objectNameChanged, receiver, &QObject::deleteLater);
+        }
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QObject>
+
+class BenchSafeConnect : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void connectDisconnect_data();
+    void connectDisconnect();
+};
@@ -0,0 +1,33 @@
+#include "bench_safepointer.h"
+
+#include <QtTest>
+
+#include "qtutils/safepointer.h"
+
+void BenchSafePointer::createDestroy()
+{
+    QBENCHMARK {
+        SafePointer<QObject> pointer(new QObject());
+    }
+}
+
+void BenchSafePointer::reset()
+{
+    SafePointer<QObject> pointer;
+    QBENCHMARK {
+        pointer = new QObject();
+        pointer.reset();
+    }
+}
+
+void BenchSafePointer::deref()
+{
+    SafePointer<QObject> pointer(new QObject());
+    int count = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            count += pointer->isWidgetType() ? 0 : 1;
+        }
+    }
+    QVERIFY(count > 0);
+}
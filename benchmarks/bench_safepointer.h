@@ -0,0 +1,13 @@
+#pragma once
+
+#include <QObject>
+
+class BenchSafePointer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void createDestroy();
+    void reset();
+    void deref();
+};
@@ -0,0 +1,117 @@
+#include "bench_snapshot.h"
+
+#include <QBuffer>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QtTest>
+#include <QUiLoader>
+
+#include "qtutils/layoutsnapshot.h"
+
+enum WidgetId { LineEditId, OkButtonId, CancelButtonId };
+
+static QWidget *createWidget(int id)
+{
+    switch (id) {
+    case LineEditId:
+        return new QLineEdit();
+    case OkButtonId:
+        return new QPushButton(QStringLiteral("OK"));
+    case CancelButtonId:
+        return new QPushButton(QStringLiteral("Cancel"));
+    }
+    return nullptr;
+}
+
+// The same dialog as created by uiDialog(), a form with text fields and a row
+// of buttons.
+static QByteArray snapshotDialog(int rows)
+{
+    QWidget dialog;
+    QHash<QWidget *, int> ids;
+    auto form = Form();
+    for (int i = 0; i < rows; ++i) {
+        auto edit = new QLineEdit();
+        ids.insert(edit, LineEditId);
+        form << Row(QStringLiteral("Field %1").arg(i), edit);
+    }
+    auto ok = new QPushButton(QStringLiteral("OK"));
+    auto cancel = new QPushButton(QStringLiteral("Cancel"));
+    ids.insert(ok, OkButtonId);
+    ids.insert(cancel, CancelButtonId);
+
+    VBox(&dialog, Margins())
+        << form
+        << (HBox()
+            << Stretch()
+            << ok
+            << cancel);
+
+    return LayoutSnapshot::record(dialog.layout(),
+                                  [&ids](QWidget *widget) { return ids.value(widget, -1); });
+}
+
+static QByteArray uiDialog(int rows)
+{
+    QByteArray ui = "<ui version=\"4.0\"><class>Dialog</class>"
+                    "<widget class=\"QWidget\" name=\"Dialog\">"
+                    "<layout class=\"QVBoxLayout\" name=\"dialogLayout\">"
+                    "<item><layout class=\"QFormLayout\" name=\"formLayout\">";
+    for (int i = 0; i < rows; ++i) {
+        const QByteArray row = QByteArray::number(i);
+        ui += "<item row=\"" + row + "\" column=\"0\">"
+              "<widget class=\"QLabel\" name=\"label" + row + "\">"
+              "<property name=\"text\"><string>Field " + row + "</string></property>"
+              "</widget></item>"
+              "<item row=\"" + row + "\" column=\"1\">"
+              "<widget class=\"QLineEdit\" name=\"edit" + row + "\"/></item>";
+    }
+    ui += "</layout></item>"
+          "<item><layout class=\"QHBoxLayout\" name=\"buttonLayout\">"
+          "<item><spacer name=\"spacer\"><property name=\"orientation\">"
+          "<enum>Qt::Horizontal</enum></property></spacer></item>"
+          "<item><widget class=\"QPushButton\" name=\"ok\">"
+          "<property name=\"text\"><string>OK</string></property></widget></item>"
+          "<item><widget class=\"QPushButton\" name=\"cancel\">"
+          "<property name=\"text\"><string>Cancel</string></property></widget></item>"
+          "</layout></item></layout></widget></ui>";
+    return ui;
+}
+
+void BenchSnapshot::load_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<bool>("snapshot");
+
+    for (int rows : { 10, 100 }) {
+        const QByteArray count = QByteArray::number(rows);
+        QTest::newRow((count + "/QUiLoader").constData()) << rows << false;
+        QTest::newRow((count + "/LayoutSnapshot").constData()) << rows << true;
+    }
+}
+
+void BenchSnapshot::load()
+{
+    QFETCH(int, rows);
+    QFETCH(bool, snapshot);
+
+    if (snapshot) {
+        const QByteArray data = snapshotDialog(rows);
+        qInfo("snapshot size: %d bytes", data.size());
+        QBENCHMARK {
+            QWidget dialog;
+            QVERIFY(LayoutSnapshot::replay(data, createWidget, &dialog));
+        }
+    } else {
+        QByteArray data = uiDialog(rows);
+        qInfo("ui size: %d bytes", data.size());
+        QUiLoader loader;
+        QBENCHMARK {
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::ReadOnly);
+            QScopedPointer<QWidget> dialog(loader.load(&buffer));
+            QVERIFY(dialog);
+        }
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QObject>
+
+class BenchSnapshot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void load_data();
+    void load();
+};
@@ -0,0 +1,33 @@
+#include "bench_translator.h"
+
+#include <QLabel>
+#include <QtTest>
+
+#include "qtutils/translator.h"
+
+void BenchTranslator::retranslate_data()
+{
+    QTest::addColumn<int>("widgets");
+
+    for (int widgets : { 100, 1000, 10000 }) {
+        QTest::newRow(QByteArray::number(widgets).constData()) << widgets;
+    }
+}
+
+void BenchTranslator::retranslate()
+{
+    QFETCH(int, widgets);
+
+    Translator translator;
+    QWidget window;
+    for (int i = 0; i < widgets; ++i) {
+        auto label = new QLabel(&window);
+        TR_TEXT(label, tr("Label"));
+        TR_TOOLTIP(label, tr("Tooltip"));
+    }
+
+    QBENCHMARK {
+        QEvent event(QEvent::LanguageChange);
+        QCoreApplication::sendEvent(qApp, &event);
+    }
+}
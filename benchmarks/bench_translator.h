@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QObject>
+
+class BenchTranslator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void retranslate_data();
+    void retranslate();
+};
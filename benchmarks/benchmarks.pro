@@ -0,0 +1,31 @@
+QT += core gui widgets testlib uitools
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = benchmarks
+
+HEADERS += \
+    bench_layouts.h \
+    bench_safeconnect.h \
+    bench_safepointer.h \
+    bench_snapshot.h \
+    bench_translator.h \
+    ../qtutils/incrementalbox.h \
+    ../qtutils/translator.h
+
+SOURCES += \
+    main.cpp \
+    bench_layouts.cpp \
+    bench_safeconnect.cpp \
+    bench_safepointer.cpp \
+    bench_snapshot.cpp \
+    bench_translator.cpp
+
+INCLUDEPATH += ..
+
+# "make benchmark" runs all benchmarks and stores machine-readable results
+# in the results subdirectory of the build directory.
+benchmark.commands = ./$$TARGET -results results
+benchmark.depends = $$TARGET
+QMAKE_EXTRA_TARGETS += benchmark
@@ -0,0 +1,56 @@
+#include <QApplication>
+#include <QDir>
+#include <QtTest>
+
+#include "bench_layouts.h"
+#include "bench_safeconnect.h"
+#include "bench_safepointer.h"
+#include "bench_snapshot.h"
+#include "bench_translator.h"
+
+//
+// Runs benchmarks of all qtutils headers. The benchmarks run headless on the
+// offscreen platform plugin unless QT_QPA_PLATFORM is set. All usual QtTest
+// arguments are passed to each benchmark class (e.g. -callgrind or
+// -iterations). With "-results <dir>", the results of each benchmark class
+// are also written to <dir>/<class>.xml in QtTest XML format, which can be
+// collected to track regressions between releases.
+//
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    QStringList arguments = app.arguments();
+    QString resultsDir;
+    const int resultsIndex = arguments.indexOf(QStringLiteral("-results"));
+    if (resultsIndex > 0 && resultsIndex + 1 < arguments.size()) {
+        resultsDir = arguments.at(resultsIndex + 1);
+        arguments.erase(arguments.begin() + resultsIndex, arguments.begin() + resultsIndex + 2);
+        QDir().mkpath(resultsDir);
+    }
+
+    BenchLayouts layouts;
+    BenchSafeConnect safeConnect;
+    BenchSafePointer safePointer;
+    BenchSnapshot snapshot;
+    BenchTranslator translator;
+    QObject *benchmarks[] = { &layouts, &safeConnect, &safePointer, &snapshot, &translator };
+
+    int status = 0;
+    for (QObject *benchmark : benchmarks) {
+        QStringList benchmarkArguments = arguments;
+        if (!resultsDir.isEmpty()) {
+            const QString name = QString::fromLatin1(benchmark->metaObject()->className());
+            benchmarkArguments << QStringLiteral("-o")
+                               << QDir(resultsDir).filePath(name + QStringLiteral(".xml,xml"))
+                               << QStringLiteral("-o") << QStringLiteral("-,txt");
+        }
+        status |= QTest::qExec(benchmark, benchmarkArguments);
+    }
+    return status;
+}
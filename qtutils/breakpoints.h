@@ -0,0 +1,421 @@
+#pragma once
+
+#include <QBoxLayout>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QHash>
+#include <QPointer>
+#include <QResizeEvent>
+#include <QSpacerItem>
+#include <QVector>
+#include <QWidget>
+
+#include <algorithm>
+#include <type_traits>
+
+#include "layouts.h"
+
+//
+// Responsive boxes, which change their direction at given widths of their
+// widget instead of being rebuilt. The toolbar below lays out its buttons in
+// a row, and in a column when the window is narrower than 480 pixels, with
+// the Spacing at index 2 shrunk to 4 pixels:
+//
+// HBox(window)
+//     << new QPushButton(tr("Open")) << new QPushButton(tr("Save"))
+//     << Spacing(24)
+//     << new QPushButton(tr("Close"))
+//     << Stretch()
+//     << Breakpoint(480, QBoxLayout::TopToBottom).setSpacing(2, 4);
+//
+// QBoxLayout turns Stretch and Spacing children across itself when the
+// direction changes, the breakpoint only overrides their sizes.
+//
+
+/**
+ * @brief Layout of a box below a given width of the widget the box lives in,
+ * added to a VBox or HBox by the << operator after the children. Below the
+ * width, the box gets the direction of the breakpoint and optionally other
+ * stretch factors of its children and other sizes of its Spacing children,
+ * identified by their index. The box returns to its previous layout when the
+ * widget gets wider than the width plus the hysteresis, so that a resize
+ * around the width does not flip the box back and forth.
+ */
+class Breakpoint final
+{
+public:
+    explicit Breakpoint(int width, QBoxLayout::Direction direction, int hysteresis = 16)
+        : m_width(width)
+        , m_direction(direction)
+        , m_hysteresis(hysteresis)
+    {}
+
+    /**
+     * @brief Sets the stretch factor of the child at index below the width.
+     */
+    Breakpoint &setStretch(int index, int stretch)
+    {
+        m_stretches.append({ index, stretch });
+        return *this;
+    }
+
+    /**
+     * @brief Sets the size of the Spacing child at index below the width.
+     */
+    Breakpoint &setSpacing(int index, int spacing)
+    {
+        m_spacings.append({ index, spacing });
+        return *this;
+    }
+
+    int width() const { return m_width; }
+
+    QBoxLayout::Direction direction() const { return m_direction; }
+
+    int hysteresis() const { return m_hysteresis; }
+
+private:
+    friend class Breakpoints;
+
+    struct Value
+    {
+        int index;
+        int value;
+    };
+
+    int m_width;
+    QBoxLayout::Direction m_direction;
+    int m_hysteresis;
+    QVector<Value> m_stretches;
+    QVector<Value> m_spacings;
+};
+
+/**
+ * @brief Registry of boxes with breakpoints, used by the << operator of
+ * Breakpoint. It watches resize events of the widget each box lives in by an
+ * event filter installed on that widget. A nested box gets its widget only
+ * when it is added to a parent layout, so until then the filter watches the
+ * child widgets and layouts of the box, which receive ParentChange when Qt
+ * reparents them to the widget of the box. These watches are removed when the
+ * box gets its widget, or when a child layout is taken from the box. The
+ * filter is a child of the application. Event filters see the events before
+ * the layouts of the widgets do, so a box crossing a breakpoint is changed
+ * before the resize is laid out and the crossing costs the one layout pass
+ * which the resize costs anyway.
+ */
+class Breakpoints final
+{
+public:
+    static void add(QBoxLayout *box, const Breakpoint &breakpoint)
+    {
+        if (!s_filter) {
+            s_filter = new ResizeFilter(qApp);
+        }
+
+        auto it = s_boxes.find(box);
+        if (it == s_boxes.end()) {
+            it = s_boxes.insert(box, State());
+            it->direction = box->direction();
+            QObject::connect(box, &QObject::destroyed, s_filter, [box] { remove(box); });
+        }
+
+        // Breakpoints are kept from the widest to the narrowest.
+        auto &breakpoints = it->breakpoints;
+        const auto position = std::find_if(breakpoints.begin(), breakpoints.end(),
+                                           [&breakpoint](const Breakpoint &other) {
+                                               return other.width() < breakpoint.width();
+                                           });
+        breakpoints.insert(position, breakpoint);
+
+        if (!attach(box, *it)) {
+            watchChildren(box, *it);
+        }
+    }
+
+    /**
+     * @brief Returns the number of times a box crossed a breakpoint.
+     */
+    static int switchCount() { return s_switchCount; }
+
+    static void resetCounters() { s_switchCount = 0; }
+
+private:
+    struct State
+    {
+        QVector<Breakpoint> breakpoints;
+        int active = -1;
+        QBoxLayout::Direction direction;
+        QHash<int, int> stretches;
+        QHash<int, int> spacings;
+        QPointer<QWidget> widget;
+        QVector<QPointer<QObject>> children;
+    };
+
+    class ResizeFilter final : public QObject
+    {
+    public:
+        using QObject::QObject;
+
+        bool eventFilter(QObject *watched, QEvent *event) override
+        {
+            switch (event->type()) {
+            case QEvent::Resize: {
+                const int width = static_cast<QResizeEvent *>(event)->size().width();
+                for (QBoxLayout *box : s_watchers.value(watched)) {
+                    const auto it = s_boxes.find(box);
+                    if (it != s_boxes.end() && it->widget == watched) {
+                        update(box, *it, width);
+                    }
+                }
+                break;
+            }
+            case QEvent::ParentChange:
+            case QEvent::ChildRemoved: {
+                // Attaching changes the watchers, iterates over a copy.
+                const QVector<QBoxLayout *> boxes = s_watchers.value(watched);
+                for (QBoxLayout *box : boxes) {
+                    const auto it = s_boxes.find(box);
+                    if (it != s_boxes.end() && !it->widget && !attach(box, *it)) {
+                        watchChildren(box, *it);
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+            }
+            return false;
+        }
+    };
+
+    /**
+     * @brief Starts watching the widget of the box, stops watching its
+     * children and updates the box for the width of the widget. Returns false
+     * if the box has no widget yet.
+     */
+    static bool attach(QBoxLayout *box, State &state)
+    {
+        QWidget *widget = box->parentWidget();
+        if (!widget) {
+            return false;
+        }
+        if (state.widget != widget) {
+            if (state.widget) {
+                unwatch(state.widget, box);
+            }
+            state.widget = widget;
+            watch(widget, box);
+        }
+        unwatchChildren(box, state);
+        update(box, state, widget->width());
+        return true;
+    }
+
+    /**
+     * @brief Watches the widgets and layouts in the layout hierarchy of a box
+     * without a widget, since Qt reparents them when the box gets its widget.
+     * Children which left the hierarchy since the last call are no longer
+     * watched.
+     */
+    static void watchChildren(QBoxLayout *box, State &state)
+    {
+        QVector<QPointer<QObject>> children{ box };
+        collectChildren(box, children);
+        for (const QPointer<QObject> &child : qAsConst(state.children)) {
+            if (child && !children.contains(child)) {
+                unwatch(child, box);
+            }
+        }
+        for (const QPointer<QObject> &child : qAsConst(children)) {
+            watch(child, box);
+        }
+        state.children = children;
+    }
+
+    static void unwatchChildren(QBoxLayout *box, State &state)
+    {
+        for (const QPointer<QObject> &child : qAsConst(state.children)) {
+            if (child) {
+                unwatch(child, box);
+            }
+        }
+        state.children.clear();
+    }
+
+    static void collectChildren(QLayout *layout, QVector<QPointer<QObject>> &children)
+    {
+        for (int i = 0; i < layout->count(); ++i) {
+            QLayoutItem *item = layout->itemAt(i);
+            if (QWidget *widget = item->widget()) {
+                children.append(widget);
+            } else if (QLayout *child = item->layout()) {
+                children.append(child);
+                collectChildren(child, children);
+            }
+        }
+    }
+
+    /**
+     * @brief Installs the filter on an object watched for the box, once for
+     * all boxes watching the object.
+     */
+    static void watch(QObject *object, QBoxLayout *box)
+    {
+        auto it = s_watchers.find(object);
+        if (it == s_watchers.end()) {
+            it = s_watchers.insert(object, {});
+            object->installEventFilter(s_filter);
+            QObject::connect(object, &QObject::destroyed, s_filter,
+                             [object] { s_watchers.remove(object); });
+        }
+        if (!it->contains(box)) {
+            it->append(box);
+        }
+    }
+
+    /**
+     * @brief Removes the filter from an object when no box watches it.
+     */
+    static void unwatch(QObject *object, QBoxLayout *box)
+    {
+        const auto it = s_watchers.find(object);
+        if (it == s_watchers.end()) {
+            return;
+        }
+        it->removeOne(box);
+        if (it->isEmpty()) {
+            s_watchers.erase(it);
+            object->removeEventFilter(s_filter);
+            QObject::disconnect(object, &QObject::destroyed, s_filter, nullptr);
+        }
+    }
+
+    static void remove(QBoxLayout *box)
+    {
+        const auto it = s_boxes.find(box);
+        if (it == s_boxes.end()) {
+            return;
+        }
+        unwatchChildren(box, *it);
+        if (it->widget) {
+            unwatch(it->widget, box);
+        }
+        s_boxes.erase(it);
+    }
+
+    static void update(QBoxLayout *box, State &state, int width)
+    {
+        const QVector<Breakpoint> &breakpoints = state.breakpoints;
+        int target = state.active;
+        while (target + 1 < breakpoints.size() && width < breakpoints.at(target + 1).width()) {
+            ++target;
+        }
+        while (target >= 0
+               && width >= breakpoints.at(target).width() + breakpoints.at(target).hysteresis()) {
+            --target;
+        }
+        if (target != state.active) {
+            activate(box, state, target);
+            ++s_switchCount;
+        }
+    }
+
+    static bool isHorizontal(QBoxLayout::Direction direction)
+    {
+        return direction == QBoxLayout::LeftToRight || direction == QBoxLayout::RightToLeft;
+    }
+
+    /**
+     * @brief Changes the box to the breakpoint at index, or to its original
+     * layout if index is -1. Spacer sizes are read and changed along the
+     * direction of the active breakpoint, i.e. restored before the direction
+     * changes and overridden after it, since setDirection() turns Stretch
+     * and Spacing children across.
+     */
+    static void activate(QBoxLayout *box, State &state, int index)
+    {
+        // Restores values changed by the previous breakpoint.
+        if (state.active >= 0) {
+            for (const auto &stretch : state.breakpoints.at(state.active).m_stretches) {
+                box->setStretch(stretch.index, state.stretches.value(stretch.index));
+            }
+            for (const auto &spacing : state.breakpoints.at(state.active).m_spacings) {
+                resizeSpacer(box, spacing.index, state.spacings.value(spacing.index));
+            }
+        }
+        state.active = index;
+
+        box->setDirection(index >= 0 ? state.breakpoints.at(index).direction() : state.direction);
+
+        if (index >= 0) {
+            const Breakpoint &breakpoint = state.breakpoints.at(index);
+            for (const auto &stretch : breakpoint.m_stretches) {
+                if (!state.stretches.contains(stretch.index)) {
+                    state.stretches.insert(stretch.index, box->stretch(stretch.index));
+                }
+                box->setStretch(stretch.index, stretch.value);
+            }
+            for (const auto &spacing : breakpoint.m_spacings) {
+                if (!state.spacings.contains(spacing.index)) {
+                    state.spacings.insert(spacing.index, spacerSize(box, spacing.index));
+                }
+                resizeSpacer(box, spacing.index, spacing.value);
+            }
+        }
+        box->invalidate();
+    }
+
+    /**
+     * @brief Returns the size of the spacer at index along the current
+     * direction of the box.
+     */
+    static int spacerSize(QBoxLayout *box, int index)
+    {
+        QLayoutItem *item = box->itemAt(index);
+        if (!item || !item->spacerItem()) {
+            return 0;
+        }
+        const QSize size = item->spacerItem()->sizeHint();
+        return isHorizontal(box->direction()) ? size.width() : size.height();
+    }
+
+    /**
+     * @brief Changes the size of the spacer at index along the current
+     * direction of the box.
+     */
+    static void resizeSpacer(QBoxLayout *box, int index, int spacing)
+    {
+        QLayoutItem *item = box->itemAt(index);
+        if (!item || !item->spacerItem()) {
+            return;
+        }
+        QSpacerItem *spacer = item->spacerItem();
+        const QSize size = spacer->sizeHint();
+        const QSizePolicy policy = spacer->sizePolicy();
+        if (isHorizontal(box->direction())) {
+            spacer->changeSize(spacing, size.height(), policy.horizontalPolicy(),
+                               policy.verticalPolicy());
+        } else {
+            spacer->changeSize(size.width(), spacing, policy.horizontalPolicy(),
+                               policy.verticalPolicy());
+        }
+    }
+
+    inline static QHash<QBoxLayout *, State> s_boxes;
+    inline static QHash<QObject *, QVector<QBoxLayout *>> s_watchers;
+    inline static QPointer<ResizeFilter> s_filter;
+    inline static int s_switchCount = 0;
+};
+
+/**
+ * @brief Adds a breakpoint to a VBox or HBox, at which the box changes its
+ * direction and optionally stretch factors and spacings of its children in
+ * place, see Breakpoint. Children are identified by their index in the
+ * wrapped layout, pending children of a batched wrapper are committed first.
+ */
+template<typename Box_T, typename = std::enable_if_t<std::is_base_of<Box, std::decay_t<Box_T>>::value>>
+Box &operator<<(Box_T &&box, const Breakpoint &breakpoint)
+{
+    Breakpoints::add(box, breakpoint);
+    return box;
+}
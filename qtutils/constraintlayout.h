@@ -0,0 +1,415 @@
+#pragma once
+
+#include <QLayout>
+#include <QStyle>
+#include <QVector>
+#include <QWidget>
+
+#include <algorithm>
+#include <cmath>
+
+#include "constraintsolver.h"
+
+#include "layouts.h"
+
+/**
+ * @brief Layout placing its items by linear constraints on their anchors,
+ * i.e. the left, top, width and height variables of each item, relative to
+ * the contents rectangle of the layout. It is used by the Constraints layout
+ * wrapper. Relations like "A's width equals B's width" or "C is centered
+ * under D" are added as constraints:
+ *
+ * layout->addConstraint(layout->anchors(a).width == layout->anchors(b).width);
+ * layout->addConstraint(layout->anchors(c).centerX() == layout->anchors(d).centerX());
+ * layout->addConstraint(layout->anchors(c).top == layout->anchors(d).bottom() + 6);
+ *
+ * Each item is kept within its minimum and maximum size and prefers its size
+ * hint with medium strength. Items stay inside the contents rectangle with
+ * strong strength, so that required constraints may push them out. Items
+ * are not placed relative to each other by default, an item without any
+ * position constraint is placed to the top left corner. The size hint of
+ * the layout is the smallest contents size satisfying the constraints, the
+ * minimum size is the smallest one with the items preferring their minimum
+ * sizes instead of their size hints.
+ *
+ * The constraints are kept in one ConstraintSolver. A resize suggests the
+ * new contents size to its edit variables and a change of a size hint
+ * replaces only the constraints of the changed item, so both are solved
+ * incrementally. The size hint and the minimum size are cached until the
+ * constraints or the sizes of the items change. The minimum size is solved
+ * by a separate solver, which is built only when it is queried after such a
+ * change. Constraints referring to removed items are kept until they are
+ * removed by removeConstraint().
+ */
+class ConstraintLayout : public QLayout
+{
+public:
+    /**
+     * @brief Variables of the geometry of an item or of the contents
+     * rectangle of the layout.
+     */
+    struct Anchors
+    {
+        Variable left;
+        Variable top;
+        Variable width;
+        Variable height;
+
+        Expression right() const { return left + width; }
+
+        Expression bottom() const { return top + height; }
+
+        Expression centerX() const { return left + width / 2; }
+
+        Expression centerY() const { return top + height / 2; }
+    };
+
+    explicit ConstraintLayout(QWidget *parent = nullptr)
+        : QLayout(parent)
+        , m_contentsConstraints{ m_contents.left == 0,
+                                 m_contents.top == 0,
+                                 m_contents.width >= 0,
+                                 m_contents.height >= 0,
+                                 (m_contents.width == 0) | Strength::Weak,
+                                 (m_contents.height == 0) | Strength::Weak }
+    {
+        for (const Constraint &constraint : qAsConst(m_contentsConstraints)) {
+            m_solver.addConstraint(constraint);
+        }
+    }
+
+    ~ConstraintLayout() override
+    {
+        for (const Entry &entry : qAsConst(m_entries)) {
+            delete entry.item;
+        }
+    }
+
+    void addItem(QLayoutItem *item) override
+    {
+        Entry entry;
+        entry.item = item;
+        const Anchors &a = entry.anchors;
+        entry.bounds = { a.left >= 0, a.top >= 0, (a.right() <= m_contents.width) | Strength::Strong,
+                         (a.bottom() <= m_contents.height) | Strength::Strong };
+        for (const Constraint &constraint : qAsConst(entry.bounds)) {
+            m_solver.addConstraint(constraint);
+        }
+        m_entries.append(entry);
+        ++m_revision;
+        invalidate();
+    }
+
+    int count() const override { return m_entries.size(); }
+
+    QLayoutItem *itemAt(int index) const override
+    {
+        return index >= 0 && index < m_entries.size() ? m_entries.at(index).item : nullptr;
+    }
+
+    QLayoutItem *takeAt(int index) override
+    {
+        if (index < 0 || index >= m_entries.size()) {
+            return nullptr;
+        }
+        const Entry entry = m_entries.takeAt(index);
+        for (const Constraint &constraint : entry.bounds + entry.sizes) {
+            m_solver.removeConstraint(constraint);
+        }
+        ++m_revision;
+        invalidate();
+        return entry.item;
+    }
+
+    /**
+     * @brief Returns the anchors of the item at index.
+     */
+    const Anchors &anchors(int index) const { return m_entries.at(index).anchors; }
+
+    /**
+     * @brief Returns the anchors of the widget, which must be an item of the
+     * layout.
+     */
+    const Anchors &anchors(QWidget *widget) const
+    {
+        const int index = indexOf(widget);
+        Q_ASSERT_X(index >= 0, "ConstraintLayout", "widget is not an item of the layout");
+        return anchors(index);
+    }
+
+    /**
+     * @brief Returns the anchors of the contents rectangle, whose left and
+     * top are zero.
+     */
+    const Anchors &contents() const { return m_contents; }
+
+    /**
+     * @brief Adds a constraint. Returns false if it was already added or if
+     * it is required and conflicts with other required constraints.
+     */
+    bool addConstraint(const Constraint &constraint)
+    {
+        if (!m_solver.addConstraint(constraint)) {
+            return false;
+        }
+        m_constraints.append(constraint);
+        ++m_revision;
+        invalidate();
+        return true;
+    }
+
+    bool removeConstraint(const Constraint &constraint)
+    {
+        if (!m_solver.removeConstraint(constraint)) {
+            return false;
+        }
+        m_constraints.erase(std::find_if(m_constraints.begin(), m_constraints.end(),
+                                         [&constraint](const Constraint &other) {
+                                             return other.id() == constraint.id();
+                                         }));
+        ++m_revision;
+        invalidate();
+        return true;
+    }
+
+    const ConstraintSolver &solver() const { return m_solver; }
+
+    Qt::Orientations expandingDirections() const override
+    {
+        return Qt::Horizontal | Qt::Vertical;
+    }
+
+    QSize sizeHint() const override
+    {
+        updateSizes();
+        if (m_hintRevision != m_revision) {
+            // The contents size without suggested values is pulled to zero
+            // by weak constraints, i.e. it is the smallest one.
+            const bool edited = m_solver.hasEditVariable(m_contents.width);
+            if (edited) {
+                m_solver.removeEditVariable(m_contents.width);
+                m_solver.removeEditVariable(m_contents.height);
+            }
+            m_solver.updateVariables();
+            m_contentsHint = contentsSize();
+            if (edited) {
+                suggest(m_suggested);
+            }
+            m_hintRevision = m_revision;
+        }
+        return withMargins(m_contentsHint);
+    }
+
+    QSize minimumSize() const override
+    {
+        updateSizes();
+        if (m_minimumRevision != m_revision) {
+            // The same constraints as in the layout's solver, except that
+            // the items prefer their minimum sizes to their size hints.
+            ConstraintSolver solver;
+            for (const Constraint &constraint : qAsConst(m_contentsConstraints)) {
+                solver.addConstraint(constraint);
+            }
+            for (const Entry &entry : qAsConst(m_entries)) {
+                const Anchors &a = entry.anchors;
+                for (const Constraint &constraint : entry.bounds + entry.sizes) {
+                    if (constraint.strength() != Strength::Medium) {
+                        solver.addConstraint(constraint);
+                    }
+                }
+                solver.addConstraint((a.width == entry.minimumSize.width()) | Strength::Medium);
+                solver.addConstraint((a.height == entry.minimumSize.height()) | Strength::Medium);
+            }
+            for (const Constraint &constraint : qAsConst(m_constraints)) {
+                solver.addConstraint(constraint);
+            }
+            solver.updateVariables();
+            m_contentsMinimum = contentsSize();
+
+            // The variables are shared by both solvers.
+            m_solver.updateVariables();
+            m_minimumRevision = m_revision;
+        }
+        return withMargins(m_contentsMinimum);
+    }
+
+    void invalidate() override
+    {
+        m_sizesDirty = true;
+        QLayout::invalidate();
+    }
+
+    void setGeometry(const QRect &rect) override
+    {
+        QLayout::setGeometry(rect);
+
+        int left, top, right, bottom;
+        getContentsMargins(&left, &top, &right, &bottom);
+        const QRect s = rect.adjusted(left, top, -right, -bottom);
+        updateSizes();
+        suggest(s.size());
+        m_solver.updateVariables();
+
+        const bool mirrored = parentWidget()
+                              && parentWidget()->layoutDirection() == Qt::RightToLeft;
+        for (const Entry &entry : qAsConst(m_entries)) {
+            const Anchors &a = entry.anchors;
+            const int x = qRound(a.left.value());
+            const int y = qRound(a.top.value());
+            const QRect r(s.x() + x, s.y() + y, qRound(a.right().value()) - x,
+                          qRound(a.bottom().value()) - y);
+            entry.item->setGeometry(mirrored ? QStyle::visualRect(Qt::RightToLeft, s, r) : r);
+        }
+    }
+
+private:
+    struct Entry
+    {
+        QLayoutItem *item = nullptr;
+        Anchors anchors;
+        QVector<Constraint> bounds;
+        QVector<Constraint> sizes;
+        QSize minimumSize;
+        QSize sizeHint;
+        QSize maximumSize;
+    };
+
+    /**
+     * @brief Replaces the size constraints of items whose minimum size, size
+     * hint or maximum size changed since the last update.
+     */
+    void updateSizes() const
+    {
+        if (!m_sizesDirty) {
+            return;
+        }
+        for (Entry &entry : m_entries) {
+            QLayoutItem *item = entry.item;
+            const QSize minimumSize = item->isEmpty() ? QSize(0, 0) : item->minimumSize();
+            const QSize sizeHint = item->isEmpty() ? QSize(0, 0) : item->sizeHint();
+            const QSize maximumSize = item->isEmpty() ? QSize(0, 0) : item->maximumSize();
+            if (!entry.sizes.isEmpty() && minimumSize == entry.minimumSize
+                && sizeHint == entry.sizeHint && maximumSize == entry.maximumSize) {
+                continue;
+            }
+            for (const Constraint &constraint : qAsConst(entry.sizes)) {
+                m_solver.removeConstraint(constraint);
+            }
+            entry.minimumSize = minimumSize;
+            entry.sizeHint = sizeHint;
+            entry.maximumSize = maximumSize;
+
+            const Anchors &a = entry.anchors;
+            entry.sizes = { a.width >= minimumSize.width(), a.height >= minimumSize.height(),
+                            (a.width == sizeHint.width()) | Strength::Medium,
+                            (a.height == sizeHint.height()) | Strength::Medium };
+            if (maximumSize.width() < QLAYOUTSIZE_MAX) {
+                entry.sizes.append(a.width <= maximumSize.width());
+            }
+            if (maximumSize.height() < QLAYOUTSIZE_MAX) {
+                entry.sizes.append(a.height <= maximumSize.height());
+            }
+            for (const Constraint &constraint : qAsConst(entry.sizes)) {
+                m_solver.addConstraint(constraint);
+            }
+            ++m_revision;
+        }
+        m_sizesDirty = false;
+    }
+
+    QSize contentsSize() const
+    {
+        return QSize(int(std::ceil(m_contents.width.value())),
+                     int(std::ceil(m_contents.height.value())));
+    }
+
+    QSize withMargins(const QSize &size) const
+    {
+        int left, top, right, bottom;
+        getContentsMargins(&left, &top, &right, &bottom);
+        return size + QSize(left + right, top + bottom);
+    }
+
+    void suggest(const QSize &size) const
+    {
+        if (!m_solver.hasEditVariable(m_contents.width)) {
+            m_solver.addEditVariable(m_contents.width, Strength::Strong);
+            m_solver.addEditVariable(m_contents.height, Strength::Strong);
+        }
+        m_solver.suggestValue(m_contents.width, size.width());
+        m_solver.suggestValue(m_contents.height, size.height());
+        m_suggested = size;
+    }
+
+    Anchors m_contents;
+    QVector<Constraint> m_contentsConstraints;
+    QVector<Constraint> m_constraints;
+
+    // The solver and the size constraints of the items are updated lazily,
+    // also by the const size queries. The revision counts changes of the
+    // constraints, the cached sizes are valid for the revision they were
+    // computed for.
+    mutable ConstraintSolver m_solver;
+    mutable QVector<Entry> m_entries;
+    mutable bool m_sizesDirty = true;
+    mutable int m_revision = 0;
+    mutable int m_hintRevision = -1;
+    mutable QSize m_contentsHint;
+    mutable int m_minimumRevision = -1;
+    mutable QSize m_contentsMinimum;
+    mutable QSize m_suggested;
+};
+
+/**
+ * @brief Layout wrapper for ConstraintLayout. Children are added like to
+ * other wrappers and placed by constraints on their anchors, which are
+ * added by the << operator as well:
+ *
+ * auto c = Constraints(dialog, Margins()) << nameEdit << emailEdit << okButton;
+ * c << (c.anchors(emailEdit).width == c.anchors(nameEdit).width)
+ *   << (c.anchors(emailEdit).top == c.anchors(nameEdit).bottom() + 6)
+ *   << (c.anchors(okButton).centerX() == c.anchors(emailEdit).centerX());
+ */
+class Constraints : public LayoutWraper<ConstraintLayout>
+{
+public:
+    explicit Constraints(QWidget *parent, const Margins &margins = Margins(0))
+        : LayoutWraper<ConstraintLayout>(createLayout<ConstraintLayout>(parent), margins,
+                                         Spacing(-1))
+    {}
+
+    explicit Constraints(const Margins &margins = Margins(0))
+        : Constraints(nullptr, margins)
+    {}
+
+    /**
+     * @brief Returns the anchors of a child widget.
+     */
+    const ConstraintLayout::Anchors &anchors(QWidget *widget) const { return p->anchors(widget); }
+
+    /**
+     * @brief Returns the anchors of the contents rectangle.
+     */
+    const ConstraintLayout::Anchors &contents() const { return p->contents(); }
+
+    /**
+     * @brief Adds a child widget. If the widget is null, it will be ignored.
+     */
+    Constraints &operator<<(QWidget *widget)
+    {
+        if (widget) {
+            p->addWidget(widget);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Adds a constraint. Required constraints conflicting with other
+     * required constraints are ignored.
+     */
+    Constraints &operator<<(const Constraint &constraint)
+    {
+        p->addConstraint(constraint);
+        return *this;
+    }
+};
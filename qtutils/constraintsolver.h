@@ -0,0 +1,846 @@
+#pragma once
+
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <optional>
+
+//
+// Linear constraints over variables, solved incrementally by an implementation
+// of the Cassowary algorithm, i.e. the simplex method on a tableau which is
+// kept between changes. Constraints can be required or preferred with a
+// strength, and variables can be edited by suggesting values:
+//
+// Variable left, width;
+// ConstraintSolver solver;
+// solver.addConstraint(left >= 0);
+// solver.addConstraint((width == 100) | Strength::Medium);
+// solver.addEditVariable(width, Strength::Strong);
+// solver.suggestValue(width, 240);
+// solver.updateVariables();
+// qInfo() << width.value();
+//
+// Variables, expressions and constraints are values, copies of a variable
+// or a constraint refer to the same variable or constraint.
+//
+
+/**
+ * @brief Strengths of constraints. Required constraints must be satisfied,
+ * the other ones are satisfied as far as possible, a stronger one before any
+ * number of weaker ones.
+ */
+class Strength final
+{
+public:
+    static constexpr double Required = 1001001000.0;
+    static constexpr double Strong = 1000000.0;
+    static constexpr double Medium = 1000.0;
+    static constexpr double Weak = 1.0;
+};
+
+/**
+ * @brief Variable of linear constraints. Its value is set by
+ * ConstraintSolver::updateVariables().
+ */
+class Variable final
+{
+public:
+    explicit Variable(const QString &name = QString())
+        : d(std::make_shared<Data>())
+    {
+        d->name = name;
+    }
+
+    const QString &name() const { return d->name; }
+
+    double value() const { return d->value; }
+
+    void setValue(double value) { d->value = value; }
+
+    /**
+     * @brief Returns a key identifying the variable, shared by its copies.
+     */
+    const void *id() const { return d.get(); }
+
+private:
+    struct Data
+    {
+        QString name;
+        double value = 0;
+    };
+
+    std::shared_ptr<Data> d;
+};
+
+/**
+ * @brief Linear expression, i.e. a sum of variables multiplied by
+ * coefficients and a constant.
+ */
+class Expression final
+{
+public:
+    struct Term
+    {
+        Variable variable;
+        double coefficient;
+    };
+
+    Expression(double constant = 0)
+        : m_constant(constant)
+    {}
+
+    Expression(const Variable &variable, double coefficient = 1)
+        : m_terms{ { variable, coefficient } }
+    {}
+
+    const QVector<Term> &terms() const { return m_terms; }
+
+    double constant() const { return m_constant; }
+
+    /**
+     * @brief Returns the value of the expression from the current values of
+     * its variables.
+     */
+    double value() const
+    {
+        double value = m_constant;
+        for (const Term &term : m_terms) {
+            value += term.coefficient * term.variable.value();
+        }
+        return value;
+    }
+
+    Expression &operator+=(const Expression &other)
+    {
+        m_terms += other.m_terms;
+        m_constant += other.m_constant;
+        return *this;
+    }
+
+    Expression &operator*=(double factor)
+    {
+        for (Term &term : m_terms) {
+            term.coefficient *= factor;
+        }
+        m_constant *= factor;
+        return *this;
+    }
+
+private:
+    QVector<Term> m_terms;
+    double m_constant = 0;
+};
+
+inline Expression operator+(Expression left, const Expression &right)
+{
+    return left += right;
+}
+
+inline Expression operator*(Expression expression, double factor)
+{
+    return expression *= factor;
+}
+
+inline Expression operator*(double factor, Expression expression)
+{
+    return expression *= factor;
+}
+
+inline Expression operator/(Expression expression, double divisor)
+{
+    return expression *= 1.0 / divisor;
+}
+
+inline Expression operator-(Expression expression)
+{
+    return expression *= -1.0;
+}
+
+inline Expression operator-(Expression left, const Expression &right)
+{
+    return left += -right;
+}
+
+/**
+ * @brief Linear constraint, i.e. a relation of an expression to zero with
+ * a strength. Constraints are usually created by comparing expressions,
+ * e.g. a.width == b.width, and given a strength by operator|.
+ */
+class Constraint final
+{
+public:
+    enum Relation { LessEqual, Equal, GreaterEqual };
+
+    Constraint(const Expression &expression, Relation relation, double strength = Strength::Required)
+        : d(std::make_shared<const Data>(
+            Data{ expression, relation, std::clamp(strength, 0.0, Strength::Required) }))
+    {}
+
+    const Expression &expression() const { return d->expression; }
+
+    Relation relation() const { return d->relation; }
+
+    double strength() const { return d->strength; }
+
+    bool isRequired() const { return d->strength >= Strength::Required; }
+
+    /**
+     * @brief Returns a new constraint with the same relation and the given
+     * strength.
+     */
+    Constraint operator|(double strength) const
+    {
+        return Constraint(d->expression, d->relation, strength);
+    }
+
+    /**
+     * @brief Returns a key identifying the constraint, shared by its copies.
+     */
+    const void *id() const { return d.get(); }
+
+private:
+    struct Data
+    {
+        Expression expression;
+        Relation relation;
+        double strength;
+    };
+
+    std::shared_ptr<const Data> d;
+};
+
+inline Constraint operator==(const Expression &left, const Expression &right)
+{
+    return Constraint(left - right, Constraint::Equal);
+}
+
+inline Constraint operator<=(const Expression &left, const Expression &right)
+{
+    return Constraint(left - right, Constraint::LessEqual);
+}
+
+inline Constraint operator>=(const Expression &left, const Expression &right)
+{
+    return Constraint(left - right, Constraint::GreaterEqual);
+}
+
+/**
+ * @brief Incremental solver of linear constraints, an implementation of the
+ * Cassowary algorithm. The solver keeps a simplex tableau in which every
+ * basic symbol is expressed by the parametric ones. Adding or removing a
+ * constraint pivots only the rows which depend on its symbols, and a value
+ * suggested for an edit variable is propagated by the dual simplex method
+ * from the rows of its edit constraint, so a resize of a layout does not
+ * solve the constraints from scratch.
+ *
+ * Methods return false for invalid requests, e.g. a constraint which is
+ * added twice, and for required constraints which cannot be satisfied.
+ */
+class ConstraintSolver final
+{
+public:
+    /**
+     * @brief Adds a constraint. Returns false if the constraint was already
+     * added or if it is required and conflicts with other required ones.
+     */
+    bool addConstraint(const Constraint &constraint)
+    {
+        if (m_constraints.contains(constraint.id())) {
+            return false;
+        }
+
+        Tag tag;
+        Row row = createRow(constraint, tag);
+        Symbol subject = chooseSubject(row, tag);
+        if (subject.type == Symbol::Invalid && allDummies(row)) {
+            if (!nearZero(row.constant)) {
+                return false;
+            }
+            subject = tag.marker;
+        }
+        if (subject.type == Symbol::Invalid) {
+            if (!addWithArtificialVariable(row)) {
+                return false;
+            }
+        } else {
+            row.solveFor(subject);
+            substitute(subject, row);
+            m_rows.insert(subject, row);
+        }
+
+        m_constraints.insert(constraint.id(), { constraint, tag });
+        optimize(m_objective);
+        return true;
+    }
+
+    /**
+     * @brief Removes a constraint. Returns false if it was not added.
+     */
+    bool removeConstraint(const Constraint &constraint)
+    {
+        const auto it = m_constraints.find(constraint.id());
+        if (it == m_constraints.end()) {
+            return false;
+        }
+        const Tag tag = it->tag;
+        m_constraints.erase(it);
+
+        // Removes the error weights from the objective.
+        if (tag.marker.type == Symbol::Error) {
+            removeMarkerEffects(tag.marker, constraint.strength());
+        }
+        if (tag.other.type == Symbol::Error) {
+            removeMarkerEffects(tag.other, constraint.strength());
+        }
+
+        // Makes the marker basic, if it is not, and drops its row.
+        if (!m_rows.remove(tag.marker)) {
+            const auto leaving = markerLeavingRow(tag.marker);
+            if (leaving == m_rows.end()) {
+                return false;
+            }
+            const Symbol symbol = leaving.key();
+            Row row = leaving.value();
+            m_rows.erase(leaving);
+            row.solveFor(symbol, tag.marker);
+            substitute(tag.marker, row);
+        }
+        optimize(m_objective);
+        return true;
+    }
+
+    bool hasConstraint(const Constraint &constraint) const
+    {
+        return m_constraints.contains(constraint.id());
+    }
+
+    int constraintCount() const { return m_constraints.size(); }
+
+    /**
+     * @brief Makes the variable editable by suggestValue(). The strength of
+     * an edit variable must not be required.
+     */
+    bool addEditVariable(const Variable &variable, double strength)
+    {
+        if (m_edits.contains(variable.id()) || strength >= Strength::Required) {
+            return false;
+        }
+        const Constraint constraint(Expression(variable), Constraint::Equal, strength);
+        if (!addConstraint(constraint)) {
+            return false;
+        }
+        m_edits.insert(variable.id(), { constraint, m_constraints.find(constraint.id())->tag, 0 });
+        return true;
+    }
+
+    bool removeEditVariable(const Variable &variable)
+    {
+        const auto it = m_edits.find(variable.id());
+        if (it == m_edits.end()) {
+            return false;
+        }
+        const Constraint constraint = it->constraint;
+        m_edits.erase(it);
+        return removeConstraint(constraint);
+    }
+
+    bool hasEditVariable(const Variable &variable) const
+    {
+        return m_edits.contains(variable.id());
+    }
+
+    /**
+     * @brief Suggests a value of an edit variable. The solution is updated
+     * incrementally, call updateVariables() to read it.
+     */
+    bool suggestValue(const Variable &variable, double value)
+    {
+        const auto it = m_edits.find(variable.id());
+        if (it == m_edits.end()) {
+            return false;
+        }
+        const double delta = value - it->constant;
+        it->constant = value;
+        const Tag tag = it->tag;
+
+        // The edit constraint is variable - plus + minus == 0. If one of its
+        // error symbols is basic, only its row changes.
+        auto row = m_rows.find(tag.marker);
+        if (row != m_rows.end()) {
+            if (row->add(-delta) < 0) {
+                m_infeasible.append(tag.marker);
+            }
+            dualOptimize();
+            return true;
+        }
+        row = m_rows.find(tag.other);
+        if (row != m_rows.end()) {
+            if (row->add(delta) < 0) {
+                m_infeasible.append(tag.other);
+            }
+            dualOptimize();
+            return true;
+        }
+
+        // Otherwise the delta is propagated to all rows depending on them.
+        for (row = m_rows.begin(); row != m_rows.end(); ++row) {
+            const double coefficient = row->coefficientFor(tag.marker);
+            if (coefficient != 0 && row->add(delta * coefficient) < 0
+                && row.key().type != Symbol::External) {
+                m_infeasible.append(row.key());
+            }
+        }
+        dualOptimize();
+        return true;
+    }
+
+    /**
+     * @brief Sets the values of all variables from the current solution.
+     */
+    void updateVariables()
+    {
+        for (auto it = m_variables.begin(); it != m_variables.end(); ++it) {
+            const auto row = m_rows.constFind(it->symbol);
+            it->variable.setValue(row == m_rows.constEnd() ? 0 : row->constant);
+        }
+    }
+
+    /**
+     * @brief Returns the number of pivots done by the solver, which measures
+     * the work done by incremental changes.
+     */
+    int pivotCount() const { return m_pivotCount; }
+
+private:
+    struct Symbol
+    {
+        enum Type { Invalid, External, Slack, Error, Dummy };
+
+        quint64 id = 0;
+        Type type = Invalid;
+
+        bool operator<(const Symbol &other) const { return id < other.id; }
+    };
+
+    /**
+     * @brief Row of the tableau, i.e. a basic symbol expressed as a constant
+     * plus a linear combination of parametric symbols.
+     */
+    struct Row
+    {
+        double add(double value) { return constant += value; }
+
+        void insert(const Symbol &symbol, double coefficient = 1)
+        {
+            double &cell = cells[symbol];
+            cell += coefficient;
+            if (nearZero(cell)) {
+                cells.remove(symbol);
+            }
+        }
+
+        void insert(const Row &other, double coefficient = 1)
+        {
+            constant += other.constant * coefficient;
+            for (auto it = other.cells.cbegin(); it != other.cells.cend(); ++it) {
+                insert(it.key(), it.value() * coefficient);
+            }
+        }
+
+        void reverseSign()
+        {
+            constant = -constant;
+            for (auto it = cells.begin(); it != cells.end(); ++it) {
+                it.value() = -it.value();
+            }
+        }
+
+        /**
+         * @brief Solves the row, which equals zero, for a symbol in it.
+         */
+        void solveFor(const Symbol &symbol)
+        {
+            const double coefficient = -1.0 / cells.take(symbol);
+            constant *= coefficient;
+            for (auto it = cells.begin(); it != cells.end(); ++it) {
+                it.value() *= coefficient;
+            }
+        }
+
+        /**
+         * @brief Solves the row of the basic symbol lhs for the symbol rhs.
+         */
+        void solveFor(const Symbol &lhs, const Symbol &rhs)
+        {
+            insert(lhs, -1.0);
+            solveFor(rhs);
+        }
+
+        double coefficientFor(const Symbol &symbol) const { return cells.value(symbol, 0); }
+
+        void substitute(const Symbol &symbol, const Row &row)
+        {
+            const auto it = cells.find(symbol);
+            if (it != cells.end()) {
+                const double coefficient = it.value();
+                cells.erase(it);
+                insert(row, coefficient);
+            }
+        }
+
+        QMap<Symbol, double> cells;
+        double constant = 0;
+    };
+
+    /**
+     * @brief Symbols of a constraint in the tableau. The marker identifies
+     * the constraint's row, other is the second error symbol of a preferred
+     * equality.
+     */
+    struct Tag
+    {
+        Symbol marker;
+        Symbol other;
+    };
+
+    struct ConstraintEntry
+    {
+        Constraint constraint;
+        Tag tag;
+    };
+
+    struct VariableEntry
+    {
+        Variable variable;
+        Symbol symbol;
+    };
+
+    struct EditEntry
+    {
+        Constraint constraint;
+        Tag tag;
+        double constant;
+    };
+
+    static bool nearZero(double value) { return std::abs(value) < 1.0e-8; }
+
+    Symbol createSymbol(Symbol::Type type) { return { m_nextId++, type }; }
+
+    Symbol variableSymbol(const Variable &variable)
+    {
+        auto it = m_variables.find(variable.id());
+        if (it == m_variables.end()) {
+            it = m_variables.insert(variable.id(), { variable, createSymbol(Symbol::External) });
+        }
+        return it->symbol;
+    }
+
+    /**
+     * @brief Creates the row of a constraint with its basic symbols
+     * substituted, adds slack and error symbols and the error weights of
+     * preferred constraints to the objective.
+     */
+    Row createRow(const Constraint &constraint, Tag &tag)
+    {
+        const Expression &expression = constraint.expression();
+        Row row;
+        row.constant = expression.constant();
+        for (const Expression::Term &term : expression.terms()) {
+            if (nearZero(term.coefficient)) {
+                continue;
+            }
+            const Symbol symbol = variableSymbol(term.variable);
+            const auto basic = m_rows.constFind(symbol);
+            if (basic != m_rows.constEnd()) {
+                row.insert(*basic, term.coefficient);
+            } else {
+                row.insert(symbol, term.coefficient);
+            }
+        }
+
+        const double strength = constraint.strength();
+        if (constraint.relation() == Constraint::Equal) {
+            if (constraint.isRequired()) {
+                tag.marker = createSymbol(Symbol::Dummy);
+                row.insert(tag.marker);
+            } else {
+                tag.marker = createSymbol(Symbol::Error);
+                tag.other = createSymbol(Symbol::Error);
+                row.insert(tag.marker, -1.0);
+                row.insert(tag.other, 1.0);
+                m_objective.insert(tag.marker, strength);
+                m_objective.insert(tag.other, strength);
+            }
+        } else {
+            const double coefficient = constraint.relation() == Constraint::LessEqual ? 1.0 : -1.0;
+            tag.marker = createSymbol(Symbol::Slack);
+            row.insert(tag.marker, coefficient);
+            if (!constraint.isRequired()) {
+                tag.other = createSymbol(Symbol::Error);
+                row.insert(tag.other, -coefficient);
+                m_objective.insert(tag.other, strength);
+            }
+        }
+
+        if (row.constant < 0) {
+            row.reverseSign();
+        }
+        return row;
+    }
+
+    /**
+     * @brief Chooses the symbol to solve a new row for: an external symbol,
+     * or a slack or error marker with a negative coefficient.
+     */
+    static Symbol chooseSubject(const Row &row, const Tag &tag)
+    {
+        for (auto it = row.cells.cbegin(); it != row.cells.cend(); ++it) {
+            if (it.key().type == Symbol::External) {
+                return it.key();
+            }
+        }
+        for (const Symbol &symbol : { tag.marker, tag.other }) {
+            if ((symbol.type == Symbol::Slack || symbol.type == Symbol::Error)
+                && row.coefficientFor(symbol) < 0) {
+                return symbol;
+            }
+        }
+        return Symbol();
+    }
+
+    static bool allDummies(const Row &row)
+    {
+        for (auto it = row.cells.cbegin(); it != row.cells.cend(); ++it) {
+            if (it.key().type != Symbol::Dummy) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Adds a row which has no subject by minimizing an artificial
+     * variable. Returns false if the row cannot be satisfied.
+     */
+    bool addWithArtificialVariable(const Row &row)
+    {
+        const Symbol artificial = createSymbol(Symbol::Slack);
+        m_rows.insert(artificial, row);
+        m_artificial = row;
+        optimize(*m_artificial);
+        const bool success = nearZero(m_artificial->constant);
+        m_artificial.reset();
+
+        const auto it = m_rows.find(artificial);
+        if (it != m_rows.end()) {
+            Row basic = it.value();
+            m_rows.erase(it);
+            if (basic.cells.isEmpty()) {
+                return success;
+            }
+            const Symbol entering = pivotableSymbol(basic);
+            if (entering.type == Symbol::Invalid) {
+                return false;
+            }
+            basic.solveFor(artificial, entering);
+            substitute(entering, basic);
+            m_rows.insert(entering, basic);
+        }
+
+        for (auto it = m_rows.begin(); it != m_rows.end(); ++it) {
+            it->cells.remove(artificial);
+        }
+        m_objective.cells.remove(artificial);
+        return success;
+    }
+
+    /**
+     * @brief Replaces the parametric symbol by its new row in all rows, the
+     * objective and the artificial objective, and remembers rows which
+     * became infeasible.
+     */
+    void substitute(const Symbol &symbol, const Row &row)
+    {
+        for (auto it = m_rows.begin(); it != m_rows.end(); ++it) {
+            it->substitute(symbol, row);
+            if (it.key().type != Symbol::External && it->constant < 0) {
+                m_infeasible.append(it.key());
+            }
+        }
+        m_objective.substitute(symbol, row);
+        if (m_artificial) {
+            m_artificial->substitute(symbol, row);
+        }
+    }
+
+    void pivot(QMap<Symbol, Row>::iterator leaving, const Symbol &entering)
+    {
+        const Symbol symbol = leaving.key();
+        Row row = leaving.value();
+        m_rows.erase(leaving);
+        row.solveFor(symbol, entering);
+        substitute(entering, row);
+        m_rows.insert(entering, row);
+        ++m_pivotCount;
+    }
+
+    /**
+     * @brief Minimizes the objective by the primal simplex method.
+     */
+    void optimize(const Row &objective)
+    {
+        for (;;) {
+            const Symbol entering = enteringSymbol(objective);
+            if (entering.type == Symbol::Invalid) {
+                return;
+            }
+            const auto leaving = leavingRow(entering);
+            if (leaving == m_rows.end()) {
+                // The objective is unbounded, which cannot happen with
+                // positive error weights.
+                return;
+            }
+            pivot(leaving, entering);
+        }
+    }
+
+    /**
+     * @brief Restores feasibility of the rows made infeasible by a suggested
+     * value by the dual simplex method.
+     */
+    void dualOptimize()
+    {
+        while (!m_infeasible.isEmpty()) {
+            const Symbol symbol = m_infeasible.takeLast();
+            const auto leaving = m_rows.find(symbol);
+            if (leaving == m_rows.end() || nearZero(leaving->constant) || leaving->constant >= 0) {
+                continue;
+            }
+            const Symbol entering = dualEnteringSymbol(*leaving);
+            if (entering.type != Symbol::Invalid) {
+                pivot(leaving, entering);
+            }
+        }
+    }
+
+    static Symbol enteringSymbol(const Row &objective)
+    {
+        for (auto it = objective.cells.cbegin(); it != objective.cells.cend(); ++it) {
+            if (it.key().type != Symbol::Dummy && it.value() < 0) {
+                return it.key();
+            }
+        }
+        return Symbol();
+    }
+
+    Symbol dualEnteringSymbol(const Row &row) const
+    {
+        Symbol entering;
+        double ratio = std::numeric_limits<double>::max();
+        for (auto it = row.cells.cbegin(); it != row.cells.cend(); ++it) {
+            if (it.value() > 0 && it.key().type != Symbol::Dummy) {
+                const double r = m_objective.coefficientFor(it.key()) / it.value();
+                if (r < ratio) {
+                    ratio = r;
+                    entering = it.key();
+                }
+            }
+        }
+        return entering;
+    }
+
+    static Symbol pivotableSymbol(const Row &row)
+    {
+        for (auto it = row.cells.cbegin(); it != row.cells.cend(); ++it) {
+            if (it.key().type == Symbol::Slack || it.key().type == Symbol::Error) {
+                return it.key();
+            }
+        }
+        return Symbol();
+    }
+
+    /**
+     * @brief Returns the row which leaves the basis when the symbol enters,
+     * by the minimum ratio test.
+     */
+    QMap<Symbol, Row>::iterator leavingRow(const Symbol &entering)
+    {
+        double ratio = std::numeric_limits<double>::max();
+        auto found = m_rows.end();
+        for (auto it = m_rows.begin(); it != m_rows.end(); ++it) {
+            if (it.key().type == Symbol::External) {
+                continue;
+            }
+            const double coefficient = it->coefficientFor(entering);
+            if (coefficient < 0) {
+                const double r = -it->constant / coefficient;
+                if (r < ratio) {
+                    ratio = r;
+                    found = it;
+                }
+            }
+        }
+        return found;
+    }
+
+    /**
+     * @brief Returns the row to pivot a parametric marker into the basis,
+     * when its constraint is removed.
+     */
+    QMap<Symbol, Row>::iterator markerLeavingRow(const Symbol &marker)
+    {
+        double firstRatio = std::numeric_limits<double>::max();
+        double secondRatio = firstRatio;
+        auto first = m_rows.end();
+        auto second = m_rows.end();
+        auto third = m_rows.end();
+        for (auto it = m_rows.begin(); it != m_rows.end(); ++it) {
+            const double coefficient = it->coefficientFor(marker);
+            if (coefficient == 0) {
+                continue;
+            }
+            if (it.key().type == Symbol::External) {
+                third = it;
+            } else if (coefficient < 0) {
+                const double r = -it->constant / coefficient;
+                if (r < firstRatio) {
+                    firstRatio = r;
+                    first = it;
+                }
+            } else {
+                const double r = it->constant / coefficient;
+                if (r < secondRatio) {
+                    secondRatio = r;
+                    second = it;
+                }
+            }
+        }
+        return first != m_rows.end() ? first : second != m_rows.end() ? second : third;
+    }
+
+    void removeMarkerEffects(const Symbol &marker, double strength)
+    {
+        const auto row = m_rows.constFind(marker);
+        if (row != m_rows.constEnd()) {
+            m_objective.insert(*row, -strength);
+        } else {
+            m_objective.insert(marker, -strength);
+        }
+    }
+
+    QHash<const void *, ConstraintEntry> m_constraints;
+    QHash<const void *, VariableEntry> m_variables;
+    QHash<const void *, EditEntry> m_edits;
+    QMap<Symbol, Row> m_rows;
+    QVector<Symbol> m_infeasible;
+    Row m_objective;
+    std::optional<Row> m_artificial;
+    quint64 m_nextId = 1;
+    int m_pivotCount = 0;
+};
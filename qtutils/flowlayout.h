@@ -0,0 +1,433 @@
+#pragma once
+
+#include <QHash>
+#include <QLayout>
+#include <QSpacerItem>
+#include <QStyle>
+#include <QVector>
+#include <QWidget>
+
+#include <algorithm>
+
+#include "layouts.h"
+
+/**
+ * @brief Layout placing its items in lines from left to right, breaking to a
+ * new line when the next item does not fit into the width of the layout. It
+ * is used by the Flow layout wrapper.
+ *
+ * Items keep their size hint widths, except for items with a non-zero
+ * stretch factor, which share the remaining space of their line. Each line is
+ * as high as its highest item, items with a vertical alignment are aligned
+ * within the line.
+ *
+ * Line breaking is cached. Size hints of the items are collected into prefix
+ * sums of widths when the layout is invalidated, so a line break is found by
+ * binary search. When the width changes, lines from the previous width are
+ * reused up to the first line which breaks differently, and only the lines
+ * after it are broken again. Results of heightForWidth() are cached per
+ * width, since they are queried repeatedly during a resize.
+ */
+class FlowLayout : public QLayout
+{
+public:
+    explicit FlowLayout(QWidget *parent = nullptr)
+        : QLayout(parent)
+    {}
+
+    ~FlowLayout() override { qDeleteAll(m_items); }
+
+    void addItem(QLayoutItem *item) override
+    {
+        m_items.append(item);
+        m_stretches.append(0);
+        invalidate();
+    }
+
+    /**
+     * @brief Adds a child layout with the given stretch factor.
+     */
+    void addLayout(QLayout *layout, int stretch = 0)
+    {
+        addChildLayout(layout);
+        addItem(layout);
+        setStretch(m_items.size() - 1, stretch);
+    }
+
+    /**
+     * @brief Adds a fixed blank space of the given width.
+     */
+    void addSpacing(int size)
+    {
+        addItem(new QSpacerItem(size, 0, QSizePolicy::Fixed, QSizePolicy::Minimum));
+    }
+
+    /**
+     * @brief Sets the stretch factor of the item at index. Stretched items
+     * share the space remaining in their line in proportion to their
+     * stretch factors.
+     */
+    void setStretch(int index, int stretch)
+    {
+        if (index >= 0 && index < m_stretches.size() && m_stretches.at(index) != stretch) {
+            m_stretches[index] = stretch;
+            invalidate();
+        }
+    }
+
+    int stretch(int index) const { return m_stretches.value(index); }
+
+    int count() const override { return m_items.size(); }
+
+    QLayoutItem *itemAt(int index) const override { return m_items.value(index); }
+
+    QLayoutItem *takeAt(int index) override
+    {
+        if (index < 0 || index >= m_items.size()) {
+            return nullptr;
+        }
+        m_stretches.remove(index);
+        QLayoutItem *item = m_items.takeAt(index);
+        invalidate();
+        return item;
+    }
+
+    /**
+     * @brief Stretched items take the space remaining in their line, so the
+     * layout expands horizontally if it has any of them.
+     */
+    Qt::Orientations expandingDirections() const override
+    {
+        const bool stretched = std::any_of(m_stretches.cbegin(), m_stretches.cend(),
+                                           [](int stretch) { return stretch > 0; });
+        return stretched ? Qt::Horizontal : Qt::Orientations();
+    }
+
+    bool hasHeightForWidth() const override { return true; }
+
+    int heightForWidth(int width) const override
+    {
+        const auto it = m_heights.constFind(width);
+        if (it != m_heights.constEnd()) {
+            return *it;
+        }
+
+        int left, top, right, bottom;
+        getContentsMargins(&left, &top, &right, &bottom);
+        const int height = breakLines(width - left - right) + top + bottom;
+        if (m_heights.size() >= MaxCachedHeights) {
+            m_heights.clear();
+        }
+        m_heights.insert(width, height);
+        return height;
+    }
+
+    QSize sizeHint() const override { return minimumSize(); }
+
+    QSize minimumSize() const override
+    {
+        QSize size;
+        for (QLayoutItem *item : m_items) {
+            size = size.expandedTo(item->minimumSize());
+        }
+        int left, top, right, bottom;
+        getContentsMargins(&left, &top, &right, &bottom);
+        return size + QSize(left + right, top + bottom);
+    }
+
+    void invalidate() override
+    {
+        m_prefix.clear();
+        m_lines.clear();
+        m_linesWidth = -1;
+        m_heights.clear();
+        QLayout::invalidate();
+    }
+
+    void setGeometry(const QRect &rect) override
+    {
+        QLayout::setGeometry(rect);
+
+        int left, top, right, bottom;
+        getContentsMargins(&left, &top, &right, &bottom);
+        const QRect s = rect.adjusted(left, top, -right, -bottom);
+        breakLines(s.width());
+
+        const bool mirrored = parentWidget()
+                              && parentWidget()->layoutDirection() == Qt::RightToLeft;
+        const int verticalSpacing = spacing(QStyle::PM_LayoutVerticalSpacing);
+        int y = s.y();
+        for (const Line &line : qAsConst(m_lines)) {
+            int stretchSum = 0;
+            for (int i = line.start; i < line.end; ++i) {
+                if (occupiesSpace(m_items.at(i))) {
+                    stretchSum += m_stretches.at(i);
+                }
+            }
+            const int remaining = std::max(0, s.width() - lineWidth(line.start, line.end));
+
+            int x = s.x();
+            int distributed = 0;
+            int stretchDone = 0;
+            for (int i = line.start; i < line.end; ++i) {
+                QLayoutItem *item = m_items.at(i);
+                if (!occupiesSpace(item)) {
+                    continue;
+                }
+                int width = m_hints.at(i).width();
+                if (m_stretches.at(i) > 0) {
+                    // Distributes the remaining space without rounding loss.
+                    stretchDone += m_stretches.at(i);
+                    const int share = remaining * stretchDone / stretchSum - distributed;
+                    distributed += share;
+                    width += share;
+                }
+                const QRect r(x, y, width, line.height);
+                item->setGeometry(mirrored ? QStyle::visualRect(Qt::RightToLeft, s, r) : r);
+                x += width + m_horizontalSpacing;
+            }
+            y += line.height + verticalSpacing;
+        }
+    }
+
+private:
+    struct Line
+    {
+        int start;
+        int end;
+        int height;
+    };
+
+    // Widths queried by heightForWidth() during a resize are mostly close
+    // to each other, so a small cache is enough and it is not allowed to
+    // grow during long interactive resizes.
+    static constexpr int MaxCachedHeights = 64;
+
+    static constexpr int DefaultSpacing = 6;
+
+    /**
+     * @brief Returns whether the item takes part in line breaking. Spacer
+     * items are empty for Qt, but a Spacing still takes its width.
+     */
+    static bool occupiesSpace(QLayoutItem *item)
+    {
+        return !item->isEmpty() || item->spacerItem();
+    }
+
+    /**
+     * @brief Returns the explicit spacing of the layout, or the default
+     * spacing of the style. Styles like Fusion return -1 for the layout
+     * spacing metrics and give the spacing by layoutSpacing() instead, a
+     * spacing still negative after that falls back to DefaultSpacing.
+     */
+    int spacing(QStyle::PixelMetric metric) const
+    {
+        if (QLayout::spacing() >= 0) {
+            return QLayout::spacing();
+        }
+        QWidget *parent = parentWidget();
+        if (!parent) {
+            return DefaultSpacing;
+        }
+        QStyle *style = parent->style();
+        int spacing = style->pixelMetric(metric, nullptr, parent);
+        if (spacing < 0) {
+            const Qt::Orientation orientation = metric == QStyle::PM_LayoutHorizontalSpacing
+                                                    ? Qt::Horizontal
+                                                    : Qt::Vertical;
+            spacing = style->layoutSpacing(QSizePolicy::DefaultType, QSizePolicy::DefaultType,
+                                           orientation, nullptr, parent);
+        }
+        return spacing >= 0 ? spacing : DefaultSpacing;
+    }
+
+    /**
+     * @brief Collects size hints of the items into prefix sums of their
+     * widths including the horizontal spacing after each non-empty item.
+     * Spacer items count only with their width, they do not make a line
+     * higher.
+     */
+    void updatePrefix() const
+    {
+        const int horizontalSpacing = spacing(QStyle::PM_LayoutHorizontalSpacing);
+        m_hints.resize(m_items.size());
+        m_prefix.resize(m_items.size() + 1);
+        m_prefix[0] = 0;
+        for (int i = 0; i < m_items.size(); ++i) {
+            QLayoutItem *item = m_items.at(i);
+            if (item->spacerItem()) {
+                m_hints[i] = QSize(item->sizeHint().width(), 0);
+            } else {
+                m_hints[i] = item->isEmpty() ? QSize(0, 0) : item->sizeHint();
+            }
+            m_prefix[i + 1] = m_prefix.at(i)
+                              + (occupiesSpace(item) ? m_hints.at(i).width() + horizontalSpacing : 0);
+        }
+        m_horizontalSpacing = horizontalSpacing;
+    }
+
+    /**
+     * @brief Returns the width of items from start to end (exclusive)
+     * including the spacing between them.
+     */
+    int lineWidth(int start, int end) const
+    {
+        const int width = m_prefix.at(end) - m_prefix.at(start);
+        return width > 0 ? width - m_horizontalSpacing : 0;
+    }
+
+    /**
+     * @brief Returns the end of the line starting at start for the width.
+     * A line contains at least one item.
+     */
+    int lineEnd(int start, int width) const
+    {
+        const int limit = m_prefix.at(start) + width + m_horizontalSpacing;
+        const auto it = std::upper_bound(m_prefix.cbegin() + start + 1, m_prefix.cend(), limit);
+        return std::max(start + 1, int(it - m_prefix.cbegin()) - 1);
+    }
+
+    /**
+     * @brief Breaks the items into lines for the width, reusing the lines
+     * of the previous width up to the first line which breaks differently.
+     * Returns the total height of the lines.
+     */
+    int breakLines(int width) const
+    {
+        if (m_prefix.isEmpty()) {
+            updatePrefix();
+        }
+        if (width != m_linesWidth) {
+            int start = 0;
+            int valid = 0;
+            for (const Line &line : qAsConst(m_lines)) {
+                if (line.end != lineEnd(line.start, width)) {
+                    break;
+                }
+                start = line.end;
+                ++valid;
+            }
+            m_lines.resize(valid);
+
+            while (start < m_items.size()) {
+                const int end = lineEnd(start, width);
+                int height = 0;
+                for (int i = start; i < end; ++i) {
+                    height = std::max(height, m_hints.at(i).height());
+                }
+                m_lines.append({ start, end, height });
+                start = end;
+            }
+            m_linesWidth = width;
+        }
+
+        int height = 0;
+        for (const Line &line : qAsConst(m_lines)) {
+            height += line.height;
+        }
+        if (!m_lines.isEmpty()) {
+            height += (m_lines.size() - 1) * spacing(QStyle::PM_LayoutVerticalSpacing);
+        }
+        return height;
+    }
+
+    QVector<QLayoutItem *> m_items;
+    QVector<int> m_stretches;
+
+    // Caches, cleared by invalidate().
+    mutable QVector<QSize> m_hints;
+    mutable QVector<int> m_prefix;
+    mutable int m_horizontalSpacing = 0;
+    mutable QVector<Line> m_lines;
+    mutable int m_linesWidth = -1;
+    mutable QHash<int, int> m_heights; // at most MaxCachedHeights entries
+};
+
+/**
+ * @brief Wrapper of FlowLayout, which places its children in lines from left
+ * to right and breaks to a new line when the next child does not fit. Use
+ * Stretched to let a child fill the rest of its line, Aligned to align a
+ * child vertically within its line and Spacing for a fixed horizontal gap.
+ */
+class Flow : public LayoutWraper<FlowLayout>
+{
+public:
+    explicit Flow(QWidget *parent,
+                  const Margins &margins = Margins(0),
+                  Spacing spacing = Spacing(-1))
+        : LayoutWraper<FlowLayout>(createLayout<FlowLayout>(parent), margins, spacing)
+    {}
+
+    explicit Flow(const Margins &margins, Spacing spacing = Spacing(-1))
+        : Flow(nullptr, margins, spacing)
+    {}
+
+    explicit Flow(Spacing spacing = Spacing(-1))
+        : Flow(nullptr, Margins(0), spacing)
+    {}
+
+    /**
+     * @brief Adds a child widget. If the widget is null, it will be ignored.
+     */
+    Flow &operator<<(QWidget *widget)
+    {
+        if (widget) {
+            p->addWidget(widget);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Adds a child layout. If the layout is null, it will be ignored.
+     */
+    Flow &operator<<(QLayout *layout)
+    {
+        if (layout) {
+            p->addLayout(layout);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Adds a child widget or layout which shares the space remaining
+     * in its line with the other stretched children of the line.
+     */
+    Flow &operator<<(const Stretched &stretched)
+    {
+        if (stretched.widget()) {
+            p->addWidget(stretched.widget());
+            p->setStretch(p->count() - 1, stretched.stretch());
+        } else if (stretched.layout()) {
+            p->addLayout(stretched.layout(), stretched.stretch());
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Adds a child widget aligned within the space given to it in
+     * its line, e.g. vertically centered in a line with higher children. The
+     * stretch factor is used like for Stretched.
+     */
+    Flow &operator<<(const Aligned &aligned)
+    {
+        if (aligned.widget()) {
+            p->addWidget(aligned.widget());
+            p->setAlignment(aligned.widget(), aligned.alignment());
+            p->setStretch(p->count() - 1, aligned.stretch());
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Adds a fixed horizontal gap of the given width. The gap takes
+     * part in line breaking like a child, but it does not make its line
+     * higher.
+     */
+    Flow &operator<<(Spacing spacing)
+    {
+        if (spacing.spacing() > 0) {
+            p->addSpacing(spacing.spacing());
+        }
+        return *this;
+    }
+};
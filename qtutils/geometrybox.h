@@ -0,0 +1,432 @@
+#pragma once
+
+#include <QLayoutItem>
+#include <QRect>
+#include <QSize>
+#include <QVector>
+
+#include <algorithm>
+
+#include "layoutparameters.h"
+
+//
+// Widget-free counterpart of VBox and HBox, which computes the rectangles of
+// items with explicit size hints, e.g. for views drawn by QPainter or for
+// precomputing layouts in worker threads. The description uses the same
+// Margins, Spacing and Stretch descriptors as the layout wrappers. Items are
+// described by Hint, which carries the stretch factor and alignment that
+// Stretched and Aligned give to widgets:
+//
+// auto box = GeometryBox(Qt::Vertical, Margins(8), Spacing(4))
+//     << Hint(QSize(200, 20))                          // title
+//     << Hint(QSize(200, 100), 1)                      // stretched content
+//     << (GeometryBox(Qt::Horizontal, Margins(0), Spacing(4))
+//         << Stretch()
+//         << Hint(QSize(80, 24), 0, Qt::AlignVCenter)  // aligned button
+//         << Hint(QSize(80, 24)));
+//
+// QRect rects[4];
+// box.layout(QRect(0, 0, 400, 300), rects);
+//
+// The description allocates while it is being built. layout() does not
+// allocate and does not modify the description, so one description can be
+// laid out concurrently from several threads. Negative spacing and margins
+// (i.e. the style defaults of the wrappers) are treated as zero, since there
+// is no style to resolve them. Space is distributed similarly to QBoxLayout:
+// below the size hint, items shrink towards their minimum sizes in
+// proportion to how much they can shrink; above it, the extra space goes to
+// stretched items up to their maximum sizes, or to all items which can grow
+// if no item is stretched.
+//
+
+/**
+ * @brief Item of GeometryBox with explicit minimum size, size hint and
+ * maximum size, stretch factor and alignment.
+ */
+class Hint final
+{
+public:
+    explicit Hint(const QSize &sizeHint,
+                  int stretch = 0,
+                  Qt::Alignment alignment = {},
+                  const QSize &minimumSize = QSize(0, 0),
+                  const QSize &maximumSize = QSize(QLAYOUTSIZE_MAX, QLAYOUTSIZE_MAX))
+        : m_minimumSize(minimumSize.boundedTo(sizeHint))
+        , m_sizeHint(sizeHint)
+        , m_maximumSize(maximumSize.expandedTo(sizeHint))
+        , m_stretch(stretch)
+        , m_alignment(alignment)
+    {}
+
+    const QSize &minimumSize() const { return m_minimumSize; }
+
+    const QSize &sizeHint() const { return m_sizeHint; }
+
+    const QSize &maximumSize() const { return m_maximumSize; }
+
+    int stretch() const { return m_stretch; }
+
+    Qt::Alignment alignment() const { return m_alignment; }
+
+private:
+    QSize m_minimumSize;
+    QSize m_sizeHint;
+    QSize m_maximumSize;
+    int m_stretch;
+    Qt::Alignment m_alignment;
+};
+
+/**
+ * @brief Widget-free box layout description, which computes rectangles of
+ * its Hint items, including the items of nested boxes.
+ */
+class GeometryBox final
+{
+public:
+    explicit GeometryBox(Qt::Orientation orientation,
+                         const Margins &margins = Margins(0),
+                         Spacing spacing = Spacing(0))
+    {
+        Node root;
+        root.kind = Node::BoxNode;
+        root.orientation = orientation;
+        const QMargins &m = margins.margins();
+        root.margins = QMargins(std::max(0, m.left()), std::max(0, m.top()),
+                                std::max(0, m.right()), std::max(0, m.bottom()));
+        root.spacing = std::max(0, spacing.spacing());
+        root.minimum = root.hint = QSize(root.margins.left() + root.margins.right(),
+                                         root.margins.top() + root.margins.bottom());
+        root.maximum = QSize(QLAYOUTSIZE_MAX, QLAYOUTSIZE_MAX);
+        root.unboundedMain = true;
+        m_nodes.append(root);
+    }
+
+    GeometryBox &operator<<(const Hint &hint)
+    {
+        Node node;
+        node.kind = Node::HintNode;
+        node.minimum = hint.minimumSize();
+        node.hint = hint.sizeHint();
+        node.maximum = hint.maximumSize();
+        node.stretch = hint.stretch();
+        node.alignment = hint.alignment();
+        node.leaf = m_leafCount++;
+        append(node);
+        return *this;
+    }
+
+    GeometryBox &operator<<(const Stretch &stretch)
+    {
+        Node node;
+        node.kind = Node::StretchNode;
+        node.maximum = QSize(QLAYOUTSIZE_MAX, QLAYOUTSIZE_MAX);
+        node.stretch = stretch.stretch();
+        append(node);
+        return *this;
+    }
+
+    GeometryBox &operator<<(Spacing spacing)
+    {
+        if (spacing.spacing() > 0) {
+            Node node;
+            node.kind = Node::SpacingNode;
+            const QSize size = main() == Qt::Horizontal ? QSize(spacing.spacing(), 0)
+                                                        : QSize(0, spacing.spacing());
+            node.minimum = node.hint = size;
+            node.maximum = main() == Qt::Horizontal ? QSize(size.width(), QLAYOUTSIZE_MAX)
+                                                    : QSize(QLAYOUTSIZE_MAX, size.height());
+            append(node);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Appends a nested box. Its Hint items follow the items added
+     * before it in the order of rectangles returned by layout().
+     */
+    GeometryBox &operator<<(const GeometryBox &box) { return append(box, 0); }
+
+    /**
+     * @brief Appends a nested box with a stretch factor.
+     */
+    GeometryBox &append(const GeometryBox &box, int stretch)
+    {
+        const int offset = m_nodes.size();
+        const int leafOffset = m_leafCount;
+        Node root = box.m_nodes.first();
+        root.stretch = stretch;
+        append(root);
+        m_nodes.reserve(m_nodes.size() + box.m_nodes.size() - 1);
+        for (int i = 1; i < box.m_nodes.size(); ++i) {
+            Node node = box.m_nodes.at(i);
+            node.end += offset;
+            if (node.leaf >= 0) {
+                node.leaf += leafOffset;
+            }
+            m_nodes.append(node);
+        }
+        m_nodes[offset].end = m_nodes.size();
+        m_nodes[0].end = m_nodes.size();
+        m_leafCount += box.m_leafCount;
+        return *this;
+    }
+
+    /**
+     * @brief Returns the number of Hint items, including nested ones, i.e.
+     * the number of rectangles written by layout().
+     */
+    int count() const { return m_leafCount; }
+
+    QSize minimumSize() const { return m_nodes.first().minimum; }
+
+    QSize sizeHint() const { return m_nodes.first().hint; }
+
+    QSize maximumSize() const { return m_nodes.first().maximum; }
+
+    /**
+     * @brief Computes the rectangles of all Hint items in rect and writes
+     * them to rects, which must have room for count() rectangles. Does not
+     * allocate and is safe to call concurrently on the same description.
+     */
+    void layout(const QRect &rect,
+                QRect *rects,
+                Qt::LayoutDirection direction = Qt::LeftToRight) const
+    {
+        layoutBox(0, rect, rects);
+        if (direction == Qt::RightToLeft) {
+            for (int i = 0; i < m_leafCount; ++i) {
+                rects[i].moveLeft(rect.left() + rect.right() - rects[i].right());
+            }
+        }
+    }
+
+private:
+    struct Node
+    {
+        enum Kind { BoxNode, HintNode, StretchNode, SpacingNode };
+
+        Kind kind = HintNode;
+        QSize minimum;
+        QSize hint;
+        QSize maximum;
+        int stretch = 0;
+        Qt::Alignment alignment;
+        int leaf = -1;
+
+        // Index after the last node of the subtree of this node.
+        int end = 0;
+
+        // Box nodes only.
+        Qt::Orientation orientation = Qt::Vertical;
+        QMargins margins;
+        int spacing = 0;
+        int children = 0;
+        int items = 0;
+        bool unboundedMain = false;
+    };
+
+    Qt::Orientation main() const { return m_nodes.first().orientation; }
+
+    static int mainOf(const QSize &size, Qt::Orientation orientation)
+    {
+        return orientation == Qt::Horizontal ? size.width() : size.height();
+    }
+
+    static int crossOf(const QSize &size, Qt::Orientation orientation)
+    {
+        return orientation == Qt::Horizontal ? size.height() : size.width();
+    }
+
+    static QSize sizeOf(int main, int cross, Qt::Orientation orientation)
+    {
+        return orientation == Qt::Horizontal ? QSize(main, cross) : QSize(cross, main);
+    }
+
+    /**
+     * @brief Appends a child node to the root box and updates the sizes of
+     * the root box.
+     */
+    void append(Node node)
+    {
+        node.end = m_nodes.size() + 1;
+        Node &root = m_nodes[0];
+        const Qt::Orientation o = root.orientation;
+        const QSize margins(root.margins.left() + root.margins.right(),
+                            root.margins.top() + root.margins.bottom());
+
+        // Like in QBoxLayout, the spacing separates items, but not the blank
+        // spaces of Stretch and Spacing.
+        const bool spaced = isSpaced(node);
+        const int spacing = spaced && root.items > 0 ? root.spacing : 0;
+
+        const int minMain = mainOf(root.minimum, o) + spacing + mainOf(node.minimum, o);
+        const int hintMain = mainOf(root.hint, o) + spacing + mainOf(node.hint, o);
+        const int minCross = std::max(crossOf(root.minimum, o), crossOf(node.minimum, o) + crossOf(margins, o));
+        const int hintCross = std::max(crossOf(root.hint, o), crossOf(node.hint, o) + crossOf(margins, o));
+
+        // The maximum along the main axis is the sum of maximums of the
+        // children, the maximum across is not limited, like in QBoxLayout
+        // with items which expand across.
+        int maxMain = QLAYOUTSIZE_MAX;
+        if (root.children == 0) {
+            maxMain = mainOf(margins, o) + mainOf(node.maximum, o);
+        } else if (!root.unboundedMain) {
+            maxMain = mainOf(root.maximum, o) + spacing + mainOf(node.maximum, o);
+        }
+        maxMain = std::min(maxMain, QLAYOUTSIZE_MAX);
+        root.unboundedMain = maxMain >= QLAYOUTSIZE_MAX;
+
+        root.minimum = sizeOf(minMain, minCross, o);
+        root.hint = sizeOf(hintMain, hintCross, o);
+        root.maximum = sizeOf(std::max(maxMain, minMain), QLAYOUTSIZE_MAX, o);
+        ++root.children;
+        if (spaced) {
+            ++root.items;
+        }
+
+        m_nodes.append(node);
+        m_nodes[0].end = m_nodes.size();
+    }
+
+    static bool isSpaced(const Node &node)
+    {
+        return node.kind == Node::BoxNode || node.kind == Node::HintNode;
+    }
+
+    void layoutBox(int index, const QRect &rect, QRect *rects) const
+    {
+        const Node &box = m_nodes.at(index);
+        const Qt::Orientation o = box.orientation;
+        const QRect s = rect.marginsRemoved(box.margins);
+        const int space = mainOf(s.size(), o) - box.spacing * std::max(0, box.items - 1);
+        const int cross = crossOf(s.size(), o);
+
+        int sumMinimum = 0;
+        int sumHint = 0;
+        int sumStretch = 0;
+        int growable = 0;
+        for (int i = index + 1; i < box.end; i = m_nodes.at(i).end) {
+            const Node &node = m_nodes.at(i);
+            sumMinimum += mainOf(node.minimum, o);
+            sumHint += mainOf(node.hint, o);
+            if (mainOf(node.maximum, o) > mainOf(node.hint, o)) {
+                sumStretch += node.stretch;
+                ++growable;
+            }
+        }
+
+        // Extra space per unit of stretch above the size hint. Items whose
+        // maximum size is reached are capped and the level rises for the
+        // others, until no more items get capped.
+        double level = 0;
+        if (space > sumHint && growable > 0) {
+            const bool byStretch = sumStretch > 0;
+            const int extra = space - sumHint;
+            level = double(extra) / (byStretch ? sumStretch : growable);
+            for (;;) {
+                double capped = 0;
+                int units = 0;
+                for (int i = index + 1; i < box.end; i = m_nodes.at(i).end) {
+                    const Node &node = m_nodes.at(i);
+                    const int weight = byStretch ? node.stretch : 1;
+                    const int room = mainOf(node.maximum, o) - mainOf(node.hint, o);
+                    if (weight <= 0 || room <= 0) {
+                        continue;
+                    }
+                    if (room < weight * level) {
+                        capped += room;
+                    } else {
+                        units += weight;
+                    }
+                }
+                if (units == 0) {
+                    break;
+                }
+                const double next = (extra - capped) / units;
+                if (next <= level) {
+                    break;
+                }
+                level = next;
+            }
+        }
+
+        double position = o == Qt::Horizontal ? s.x() : s.y();
+        int start = int(position);
+        bool first = true;
+        for (int i = index + 1; i < box.end; i = m_nodes.at(i).end) {
+            const Node &node = m_nodes.at(i);
+            if (isSpaced(node)) {
+                if (!first) {
+                    position += box.spacing;
+                    start += box.spacing;
+                }
+                first = false;
+            }
+
+            const int minimum = mainOf(node.minimum, o);
+            const int hint = mainOf(node.hint, o);
+            double size = hint;
+            if (space <= 0) {
+                // Also covers items without minimum sizes to shrink by.
+                size = 0;
+            } else if (space < sumMinimum) {
+                size = double(space) * minimum / sumMinimum;
+            } else if (space < sumHint) {
+                const int shrinkable = sumHint - sumMinimum;
+                size = hint - double(sumHint - space) * (hint - minimum) / shrinkable;
+            } else if (level > 0) {
+                const int weight = sumStretch > 0 ? node.stretch : 1;
+                const int room = mainOf(node.maximum, o) - hint;
+                if (weight > 0 && room > 0) {
+                    size = hint + std::min(double(room), weight * level);
+                }
+            }
+
+            // Rounds the positions rather than the sizes, so that the
+            // rounding errors do not accumulate.
+            position += size;
+            const int end = qRound(position);
+
+            const QRect cell = o == Qt::Horizontal ? QRect(start, s.y(), end - start, cross)
+                                                   : QRect(s.x(), start, cross, end - start);
+            switch (node.kind) {
+            case Node::BoxNode:
+                layoutBox(i, cell, rects);
+                break;
+            case Node::HintNode:
+                rects[node.leaf] = place(node, cell);
+                break;
+            case Node::StretchNode:
+            case Node::SpacingNode:
+                break;
+            }
+            start = end;
+        }
+    }
+
+    /**
+     * @brief Returns the rectangle of an item within its cell. Aligned items
+     * get their size hint, the others fill the cell up to their maximum size.
+     */
+    static QRect place(const Node &node, const QRect &cell)
+    {
+        QSize size = node.alignment ? node.hint : node.maximum;
+        size = size.boundedTo(node.maximum).boundedTo(cell.size());
+        int x = cell.x();
+        int y = cell.y();
+        if (node.alignment & Qt::AlignRight) {
+            x += cell.width() - size.width();
+        } else if (node.alignment & Qt::AlignHCenter) {
+            x += (cell.width() - size.width()) / 2;
+        }
+        if (node.alignment & Qt::AlignBottom) {
+            y += cell.height() - size.height();
+        } else if (node.alignment & Qt::AlignVCenter) {
+            y += (cell.height() - size.height()) / 2;
+        }
+        return QRect(x, y, size.width(), size.height());
+    }
+
+    QVector<Node> m_nodes;
+    int m_leafCount = 0;
+};
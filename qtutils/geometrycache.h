@@ -0,0 +1,199 @@
+#pragma once
+
+#include <QLayout>
+#include <QVector>
+#include <QWidget>
+
+#include <utility>
+
+/**
+ * @brief Opt-in cache of the geometries computed by top-level layouts, i.e.
+ * layouts created by wrappers with a parent widget. When enabled, such
+ * wrappers create layouts which remember the geometries of all widgets and
+ * nested layouts of their hierarchy for the last few sizes of the parent
+ * widget. When the widget is resized back to one of these sizes, e.g. when
+ * the window is toggled between maximized and normal, the geometries are set
+ * directly instead of being computed by the whole layout hierarchy again.
+ *
+ * The entries are keyed by the layout rectangle, the device pixel ratio and
+ * the layout direction of the parent widget. All entries of a layout are
+ * dropped when the layout is invalidated, which happens when any widget of
+ * the hierarchy calls updateGeometry(), is shown, hidden, added or removed.
+ *
+ * The cache must be enabled before the layouts are created. It is meant to
+ * be used from the GUI thread only:
+ *
+ * GeometryCache::setEnabled(true);
+ * VBox(dashboard) << ...;
+ */
+class GeometryCache final
+{
+public:
+    /**
+     * @brief Enables or disables the cache for top-level layouts created by
+     * layout wrappers from now on. Disabled by default.
+     */
+    static void setEnabled(bool enabled) { s_enabled = enabled; }
+
+    static bool isEnabled() { return s_enabled; }
+
+    /**
+     * @brief Sets the maximum number of sizes remembered by each layout. The
+     * least recently used size is dropped first. Default is 4.
+     */
+    static void setCapacity(int capacity) { s_capacity = capacity; }
+
+    static int capacity() { return s_capacity; }
+
+    /**
+     * @brief Returns the number of setGeometry() calls of cached layouts
+     * served from the cache and computed by the layout, respectively.
+     */
+    static int hitCount() { return s_hitCount; }
+
+    static int missCount() { return s_missCount; }
+
+    static void resetCounters()
+    {
+        s_hitCount = 0;
+        s_missCount = 0;
+    }
+
+private:
+    template<typename Layout_T>
+    friend class CachedLayout;
+
+    inline static bool s_enabled = false;
+    inline static int s_capacity = 4;
+    inline static int s_hitCount = 0;
+    inline static int s_missCount = 0;
+};
+
+/**
+ * @brief Layout with a geometry cache, see GeometryCache. Layout wrappers
+ * create it instead of Layout_T for top-level layouts when the cache is
+ * enabled.
+ */
+template<typename Layout_T>
+class CachedLayout : public Layout_T
+{
+public:
+    template<typename... Args_T>
+    explicit CachedLayout(Args_T &&...args)
+        : Layout_T(std::forward<Args_T>(args)...)
+    {}
+
+    void setGeometry(const QRect &rect) override
+    {
+        const QWidget *parent = this->parentWidget();
+        const qreal ratio = parent ? parent->devicePixelRatioF() : 1;
+        const Qt::LayoutDirection direction = parent ? parent->layoutDirection()
+                                                     : Qt::LeftToRight;
+
+        for (int i = 0; i < m_entries.size(); ++i) {
+            const Entry &entry = m_entries.at(i);
+            if (entry.rect != rect || entry.ratio != ratio || entry.direction != direction) {
+                continue;
+            }
+            QLayout::setGeometry(rect);
+            int index = 0;
+            if (replay(this, entry.records, index) && index == entry.records.size()) {
+                m_entries.move(i, 0);
+                ++GeometryCache::s_hitCount;
+                return;
+            }
+            // An item was removed and the invalidation has not reached this
+            // layout yet, computes the geometry below.
+            m_entries.clear();
+            break;
+        }
+
+        Layout_T::setGeometry(rect);
+        ++GeometryCache::s_missCount;
+        if (GeometryCache::s_capacity <= 0) {
+            return;
+        }
+
+        if (m_entries.size() >= GeometryCache::s_capacity) {
+            m_entries.resize(GeometryCache::s_capacity - 1);
+        }
+        Entry entry{ rect, ratio, direction, {} };
+        entry.records.reserve(m_recordCount);
+        record(this, entry.records);
+        m_recordCount = entry.records.size();
+        m_entries.prepend(std::move(entry));
+    }
+
+    void invalidate() override
+    {
+        m_entries.clear();
+        Layout_T::invalidate();
+    }
+
+private:
+    /**
+     * @brief Geometry of an item of the hierarchy, i.e. of a widget, a nested
+     * layout or another item, like a spacer.
+     */
+    struct Record
+    {
+        QLayoutItem *item;
+        QRect geometry;
+    };
+
+    struct Entry
+    {
+        QRect rect;
+        qreal ratio;
+        Qt::LayoutDirection direction;
+        QVector<Record> records;
+    };
+
+    static void record(QLayout *layout, QVector<Record> &records)
+    {
+        for (int i = 0; i < layout->count(); ++i) {
+            QLayoutItem *item = layout->itemAt(i);
+            if (QWidget *widget = item->widget()) {
+                records.append({ item, widget->geometry() });
+            } else if (QLayout *child = item->layout()) {
+                records.append({ item, child->geometry() });
+                record(child, records);
+            } else {
+                records.append({ item, item->geometry() });
+            }
+        }
+    }
+
+    /**
+     * @brief Sets the recorded geometries while walking the hierarchy in the
+     * same order as record(). Nested layouts only store their rectangle,
+     * since the geometries of their items are set directly. Returns false
+     * when the hierarchy no longer matches the records.
+     */
+    static bool replay(QLayout *layout, const QVector<Record> &records, int &index)
+    {
+        for (int i = 0; i < layout->count(); ++i) {
+            QLayoutItem *item = layout->itemAt(i);
+            if (index >= records.size() || records.at(index).item != item) {
+                return false;
+            }
+            const QRect &geometry = records.at(index++).geometry;
+            if (QWidget *widget = item->widget()) {
+                if (!item->isEmpty()) {
+                    widget->setGeometry(geometry);
+                }
+            } else if (QLayout *child = item->layout()) {
+                child->QLayout::setGeometry(geometry);
+                if (!replay(child, records, index)) {
+                    return false;
+                }
+            } else {
+                item->setGeometry(geometry);
+            }
+        }
+        return true;
+    }
+
+    QVector<Entry> m_entries;
+    int m_recordCount = 0;
+};
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QTimerEvent>
+#include <QVector>
+
+#include "layouts.h"
+
+/**
+ * Fills a VBox or HBox with a large number of children without blocking the
+ * event loop. The builder accepts the same children as Box::operator<<, but
+ * only queues them. After start(), the children are added to the box in
+ * chunks, one chunk per event loop iteration, each chunk taking at most the
+ * time budget. The builder reports progress after each chunk and emits
+ * finished() when all children are added.
+ * Usage:
+ * auto builder = new IncrementalBox(VBox(panel), panel);
+ * for (auto row : rows) {
+ *     *builder << createRowWidget(row);
+ * }
+ * connect(builder, &IncrementalBox::finished, builder, &QObject::deleteLater);
+ * builder->start();
+ *
+ * Children still queued when the builder is destroyed are added at once, or
+ * deleted if the layout no longer exists.
+ */
+class IncrementalBox : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit IncrementalBox(const Box &box, QObject *parent = nullptr)
+        : QObject(parent)
+        , m_box(box)
+        , m_layout(static_cast<QBoxLayout *>(box))
+    {}
+
+    ~IncrementalBox() override
+    {
+        if (m_layout) {
+            addPending(-1);
+        } else {
+            for (int i = m_next; i < m_items.size(); ++i) {
+                delete m_items.at(i).widget;
+                delete m_items.at(i).layout;
+            }
+        }
+    }
+
+    /**
+     * @brief Sets the maximum time in milliseconds spent adding children in
+     * one event loop iteration. At least one child is added in each
+     * iteration. Default is 4 ms.
+     */
+    void setTimeBudget(int milliseconds) { m_timeBudget = milliseconds; }
+
+    int timeBudget() const { return m_timeBudget; }
+
+    IncrementalBox &operator<<(QWidget *widget)
+    {
+        if (widget) {
+            m_items.append({ Item::WidgetItem, widget, nullptr, 0, {} });
+        }
+        return *this;
+    }
+
+    IncrementalBox &operator<<(QLayout *layout)
+    {
+        if (layout) {
+            m_items.append({ Item::LayoutItem, nullptr, layout, 0, {} });
+        }
+        return *this;
+    }
+
+    IncrementalBox &operator<<(const Stretch &stretch)
+    {
+        m_items.append({ Item::StretchItem, nullptr, nullptr, stretch.stretch(), {} });
+        return *this;
+    }
+
+    IncrementalBox &operator<<(const Stretched &stretched)
+    {
+        if (stretched.widget() || stretched.layout()) {
+            m_items.append({ Item::StretchedItem, stretched.widget(), stretched.layout(),
+                             stretched.stretch(), {} });
+        }
+        return *this;
+    }
+
+    IncrementalBox &operator<<(const Aligned &aligned)
+    {
+        if (aligned.widget()) {
+            m_items.append({ Item::AlignedItem, aligned.widget(), nullptr, aligned.stretch(),
+                             aligned.alignment() });
+        }
+        return *this;
+    }
+
+    IncrementalBox &operator<<(Spacing spacing)
+    {
+        m_items.append({ Item::SpacingItem, nullptr, nullptr, spacing.spacing(), {} });
+        return *this;
+    }
+
+    /**
+     * @brief Starts adding the queued children from the next event loop
+     * iteration. Children queued later are added as well.
+     */
+    void start()
+    {
+        if (m_timerId == 0) {
+            m_timerId = startTimer(0);
+        }
+    }
+
+    /**
+     * @brief Adds all queued children immediately.
+     */
+    void finish()
+    {
+        addPending(-1);
+        complete();
+    }
+
+    bool isFinished() const { return m_next == m_items.size(); }
+
+    int count() const { return m_items.size(); }
+
+    int addedCount() const { return m_next; }
+
+signals:
+    /**
+     * @brief Emitted after each chunk of children is added.
+     */
+    void progress(int added, int total);
+
+    /**
+     * @brief Emitted when all children are added, or when the layout was
+     * destroyed before, so that a builder connected to deleteLater() is
+     * always released. Children which were not added are deleted with the
+     * builder then.
+     */
+    void finished();
+
+protected:
+    void timerEvent(QTimerEvent *event) override
+    {
+        if (event->timerId() != m_timerId) {
+            QObject::timerEvent(event);
+            return;
+        }
+        if (!m_layout) {
+            complete();
+            return;
+        }
+        addPending(m_timeBudget);
+        emit progress(m_next, m_items.size());
+        if (isFinished()) {
+            complete();
+        }
+    }
+
+private:
+    struct Item
+    {
+        enum Kind { WidgetItem, LayoutItem, StretchItem, StretchedItem, AlignedItem, SpacingItem };
+
+        Kind kind;
+        QWidget *widget;
+        QLayout *layout;
+        int value;
+        Qt::Alignment alignment;
+    };
+
+    /**
+     * @brief Adds queued children until the time budget in milliseconds runs
+     * out, or all of them if the budget is negative.
+     */
+    void addPending(int budget)
+    {
+        if (!m_layout) {
+            return;
+        }
+        QElapsedTimer timer;
+        timer.start();
+        while (m_next < m_items.size()) {
+            const Item &item = m_items.at(m_next++);
+            switch (item.kind) {
+            case Item::WidgetItem:
+                m_box << item.widget;
+                break;
+            case Item::LayoutItem:
+                m_box << item.layout;
+                break;
+            case Item::StretchItem:
+                m_box << Stretch(item.value);
+                break;
+            case Item::StretchedItem:
+                if (item.widget) {
+                    m_box << Stretched(item.widget, item.value);
+                } else {
+                    m_box << Stretched(item.layout, item.value);
+                }
+                break;
+            case Item::AlignedItem:
+                m_box << Aligned(item.widget, item.alignment, item.value);
+                break;
+            case Item::SpacingItem:
+                m_box << Spacing(item.value);
+                break;
+            }
+            if (budget >= 0 && timer.elapsed() >= budget) {
+                break;
+            }
+        }
+        m_box.commit();
+    }
+
+    void complete()
+    {
+        if (m_timerId != 0) {
+            killTimer(m_timerId);
+            m_timerId = 0;
+        }
+        emit finished();
+    }
+
+    Box m_box;
+    QPointer<QBoxLayout> m_layout;
+    QVector<Item> m_items;
+    int m_next = 0;
+    int m_timeBudget = 4;
+    int m_timerId = 0;
+};
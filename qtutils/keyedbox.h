@@ -0,0 +1,280 @@
+#pragma once
+
+#include <QHash>
+#include <QVector>
+
+#include <algorithm>
+#include <functional>
+
+#include "layouts.h"
+
+//
+// Keyed description of the children of a VBox or HBox, which can be applied
+// to the same box repeatedly. Each child has a unique key. When a new
+// description is applied, the box is updated only by the difference from the
+// previous one: children with new keys are created, children with missing
+// keys are deleted, children which changed their order are moved and
+// stretch factors and alignments of the other children are updated. Widgets
+// with unchanged keys are kept as they are, so their state is preserved:
+//
+// KeyedBox panel{ VBox(widget) };
+// ...
+// QVector<Keyed> rows;
+// for (const auto &person : people) {
+//     rows << Keyed(person.id, [person] { return new PersonWidget(person); });
+// }
+// rows << Keyed("stretch", Stretch());
+// panel.apply(rows);
+//
+// The keyed box assumes that it is the only one who adds children to the
+// box. The widgets created by the factories are owned by the box and are
+// deleted when their key disappears from the description.
+//
+
+/**
+ * @brief A keyed child of KeyedBox, i.e. a widget factory, Stretch or
+ * Spacing.
+ */
+class Keyed final
+{
+public:
+    /**
+     * @brief Widget created by the factory when the key appears for the
+     * first time. The factory must not return nullptr.
+     */
+    Keyed(const QString &key,
+          std::function<QWidget *()> factory,
+          int stretch = 0,
+          Qt::Alignment alignment = {})
+        : m_key(key)
+        , m_factory(std::move(factory))
+        , m_value(stretch)
+        , m_alignment(alignment)
+    {}
+
+    Keyed(const QString &key, const Stretch &stretch)
+        : m_key(key)
+        , m_kind(StretchKind)
+        , m_value(stretch.stretch())
+    {}
+
+    Keyed(const QString &key, Spacing spacing)
+        : m_key(key)
+        , m_kind(SpacingKind)
+        , m_value(spacing.spacing())
+    {}
+
+    const QString &key() const { return m_key; }
+
+private:
+    friend class KeyedBox;
+
+    enum Kind { WidgetKind, StretchKind, SpacingKind };
+
+    QString m_key;
+    Kind m_kind = WidgetKind;
+    std::function<QWidget *()> m_factory;
+    int m_value = 0;
+    Qt::Alignment m_alignment;
+};
+
+/**
+ * @brief Applies keyed descriptions to a box layout, see Keyed.
+ */
+class KeyedBox final
+{
+public:
+    explicit KeyedBox(QBoxLayout *layout)
+        : m_layout(layout)
+    {}
+
+    /**
+     * @brief Updates the box to contain the given children in the given
+     * order. Children are moved along the longest subsequence of children
+     * which kept their relative order, so the number of moves is minimal.
+     */
+    void apply(const QVector<Keyed> &items)
+    {
+        m_inserted = 0;
+        m_removed = 0;
+        m_moved = 0;
+
+        QHash<QString, int> newIndexes;
+        newIndexes.reserve(items.size());
+        for (int i = 0; i < items.size(); ++i) {
+            Q_ASSERT_X(!newIndexes.contains(items.at(i).key()), "KeyedBox", "duplicate key");
+            newIndexes.insert(items.at(i).key(), i);
+        }
+
+        // New index of each current child, or -1 if it is to be deleted.
+        QVector<int> targets(m_entries.size(), -1);
+        for (int j = 0; j < m_entries.size(); ++j) {
+            const auto it = newIndexes.constFind(m_entries.at(j).key);
+            if (it != newIndexes.constEnd() && isReusable(m_entries.at(j), items.at(*it))) {
+                targets[j] = *it;
+            }
+        }
+        const QVector<bool> kept = longestIncreasing(targets);
+
+        // Take out all children which are not kept at their place, from the
+        // end, so that indexes of the remaining children do not change.
+        QHash<QString, Entry> moving;
+        QHash<QString, int> keptIndexes;
+        for (int j = m_entries.size() - 1; j >= 0; --j) {
+            const Entry &entry = m_entries.at(j);
+            if (kept.at(j)) {
+                keptIndexes.insert(entry.key, j);
+                continue;
+            }
+            delete m_layout->takeAt(j);
+            if (targets.at(j) >= 0 && entry.widget) {
+                moving.insert(entry.key, entry);
+            } else {
+                delete entry.widget;
+                ++m_removed;
+            }
+        }
+
+        // Now the layout contains only the kept children in the right order,
+        // so the others can be inserted at their final indexes one by one.
+        QVector<Entry> entries;
+        entries.reserve(items.size());
+        for (int i = 0; i < items.size(); ++i) {
+            const Keyed &item = items.at(i);
+            Entry entry;
+            const auto keptIt = keptIndexes.constFind(item.m_key);
+            if (keptIt != keptIndexes.constEnd()) {
+                entry = m_entries.at(*keptIt);
+                update(i, entry, item);
+            } else if (moving.contains(item.m_key)) {
+                entry = moving.take(item.m_key);
+                m_layout->insertWidget(i, entry.widget, item.m_value, item.m_alignment);
+                entry.value = item.m_value;
+                entry.alignment = item.m_alignment;
+                ++m_moved;
+            } else {
+                entry = create(i, item);
+                ++m_inserted;
+            }
+            entries.append(entry);
+        }
+        m_entries = entries;
+    }
+
+    /**
+     * @brief Returns the widget with the given key, or nullptr if there is
+     * no such widget.
+     */
+    QWidget *widget(const QString &key) const
+    {
+        for (const Entry &entry : m_entries) {
+            if (entry.key == key) {
+                return entry.widget;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Returns the number of children created, deleted and moved by
+     * the last apply().
+     */
+    int insertedCount() const { return m_inserted; }
+
+    int removedCount() const { return m_removed; }
+
+    int movedCount() const { return m_moved; }
+
+private:
+    struct Entry
+    {
+        QString key;
+        Keyed::Kind kind = Keyed::WidgetKind;
+        QWidget *widget = nullptr;
+        int value = 0;
+        Qt::Alignment alignment;
+    };
+
+    static bool isReusable(const Entry &entry, const Keyed &item)
+    {
+        if (entry.kind != item.m_kind) {
+            return false;
+        }
+        // Spacing items cannot be resized, they are recreated instead.
+        return entry.kind != Keyed::SpacingKind || entry.value == item.m_value;
+    }
+
+    /**
+     * @brief Returns the flags of values forming the longest strictly
+     * increasing subsequence of the non-negative values (patience sorting).
+     */
+    static QVector<bool> longestIncreasing(const QVector<int> &values)
+    {
+        QVector<int> tails;        // index of the last value of subsequences by length
+        QVector<int> previous(values.size(), -1);
+        for (int j = 0; j < values.size(); ++j) {
+            if (values.at(j) < 0) {
+                continue;
+            }
+            const auto it = std::lower_bound(tails.begin(), tails.end(), values.at(j),
+                                             [&values](int index, int value) {
+                                                 return values.at(index) < value;
+                                             });
+            if (it != tails.begin()) {
+                previous[j] = *(it - 1);
+            }
+            if (it == tails.end()) {
+                tails.append(j);
+            } else {
+                *it = j;
+            }
+        }
+
+        QVector<bool> result(values.size(), false);
+        for (int j = tails.isEmpty() ? -1 : tails.last(); j >= 0; j = previous.at(j)) {
+            result[j] = true;
+        }
+        return result;
+    }
+
+    Entry create(int index, const Keyed &item)
+    {
+        Entry entry;
+        entry.key = item.m_key;
+        entry.kind = item.m_kind;
+        entry.value = item.m_value;
+        entry.alignment = item.m_alignment;
+        switch (item.m_kind) {
+        case Keyed::WidgetKind:
+            entry.widget = item.m_factory();
+            Q_ASSERT_X(entry.widget, "KeyedBox", "widget factory returned nullptr");
+            m_layout->insertWidget(index, entry.widget, item.m_value, item.m_alignment);
+            break;
+        case Keyed::StretchKind:
+            m_layout->insertStretch(index, item.m_value);
+            break;
+        case Keyed::SpacingKind:
+            m_layout->insertSpacing(index, item.m_value);
+            break;
+        }
+        return entry;
+    }
+
+    void update(int index, Entry &entry, const Keyed &item)
+    {
+        if (entry.value != item.m_value) {
+            m_layout->setStretch(index, item.m_value);
+            entry.value = item.m_value;
+        }
+        if (entry.widget && entry.alignment != item.m_alignment) {
+            m_layout->setAlignment(entry.widget, item.m_alignment);
+            entry.alignment = item.m_alignment;
+        }
+    }
+
+    QBoxLayout *m_layout;
+    QVector<Entry> m_entries;
+    int m_inserted = 0;
+    int m_removed = 0;
+    int m_moved = 0;
+};
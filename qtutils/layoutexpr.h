@@ -0,0 +1,302 @@
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "layouts.h"
+
+//
+// Expression-template variant of the VBox and HBox layout wrappers. VBoxExpr
+// and HBoxExpr accept the same children as VBox and HBox, i.e. widgets,
+// layouts, nested expressions, Stretch, Stretched, Aligned and Spacing.
+// Unlike VBox and HBox, they do not allocate anything while the expression is
+// being built. The whole nested hierarchy is captured in the type of the
+// expression and all layouts are created in a single depth-first pass at the
+// end:
+//
+// (HBoxExpr(dialog, Margins())
+//     << (VBoxExpr()
+//         << icon
+//         << Stretch())
+//     << Spacing(8)
+//     << (VBoxExpr()
+//         << text
+//         << Stretch()
+//         << (HBoxExpr()
+//             << Stretch()
+//             << okBtn
+//             << cancelBtn)))
+//     .create();
+//
+// The layouts are created only when the outermost expression is converted to
+// the layout pointer or when create() is called, also for expressions with a
+// parent widget. Nested branches which contain only nullptr widgets and
+// layouts (or further empty branches) are skipped and no layout object is
+// created for them. The top-level layout is installed to its parent widget
+// only after it is filled, so the children are reparented in one step.
+//
+// Expressions always create plain QVBoxLayout and QHBoxLayout objects. The
+// options of the layout wrappers, i.e. Box::setDefaultEngine(), StyleMetrics,
+// LayoutProfiler, GeometryCache and ResizeCoalescing, do not apply to them.
+//
+// Since each << creates a new type, expressions are meant for hierarchies
+// written out in code. Use VBox and HBox for children added in loops.
+//
+// An outermost expression which is destroyed without being converted or
+// created creates nothing, which asserts in debug builds, e.g. when an
+// expression is stored in a variable and the create() call is forgotten.
+//
+
+template<QBoxLayout::Direction Direction_T, typename... Items_T>
+class BoxExpr;
+
+template<typename T>
+struct IsBoxExpr : std::false_type
+{};
+
+template<QBoxLayout::Direction Direction_T, typename... Items_T>
+struct IsBoxExpr<BoxExpr<Direction_T, Items_T...>> : std::true_type
+{};
+
+/**
+ * @brief Maps the type of a child passed to BoxExpr::operator<< to the type
+ * in which it is stored in the expression. Nested expressions and item
+ * classes are stored by value. Pointers to widgets and layouts, as well as
+ * layout wrappers, are stored as QWidget and QLayout pointers. Note that
+ * layout wrappers create their layouts eagerly, so they are never skipped as
+ * empty branches.
+ */
+template<typename T>
+struct BoxExprItem
+{
+    using Decayed = std::decay_t<T>;
+
+    using type = std::conditional_t<
+        IsBoxExpr<Decayed>::value,
+        Decayed,
+        std::conditional_t<std::is_convertible<Decayed, QWidget *>::value,
+                           QWidget *,
+                           std::conditional_t<std::is_convertible<Decayed, QLayout *>::value,
+                                              QLayout *,
+                                              Decayed>>>;
+};
+
+/**
+ * @brief Expression capturing a box layout and all its children. Use the
+ * VBoxExpr and HBoxExpr aliases instead of naming this class directly.
+ */
+template<QBoxLayout::Direction Direction_T, typename... Items_T>
+class BoxExpr
+{
+public:
+    using Layout_T = std::conditional_t<Direction_T == QBoxLayout::TopToBottom,
+                                        QVBoxLayout,
+                                        std::conditional_t<Direction_T == QBoxLayout::LeftToRight,
+                                                           QHBoxLayout,
+                                                           QBoxLayout>>;
+
+    explicit BoxExpr(QWidget *parent,
+                     const Margins &margins = Margins(0),
+                     Spacing spacing = Spacing(-1))
+        : m_parent(parent)
+        , m_margins(margins)
+        , m_spacing(spacing)
+    {}
+
+    explicit BoxExpr(const Margins &margins, Spacing spacing = Spacing(-1))
+        : BoxExpr(nullptr, margins, spacing)
+    {}
+
+    explicit BoxExpr(Spacing spacing = Spacing(-1))
+        : BoxExpr(nullptr, Margins(0), spacing)
+    {}
+
+    BoxExpr(BoxExpr &&other)
+        : m_parent(other.m_parent)
+        , m_margins(other.m_margins)
+        , m_spacing(other.m_spacing)
+        , m_items(std::move(other.m_items))
+        , m_pending(other.m_pending)
+    {
+        other.m_pending = false;
+    }
+
+    ~BoxExpr()
+    {
+        Q_ASSERT_X(!m_pending, "BoxExpr", "expression destroyed without being created");
+    }
+
+    BoxExpr(const BoxExpr &) = delete;
+    BoxExpr &operator=(const BoxExpr &) = delete;
+    BoxExpr &operator=(BoxExpr &&) = delete;
+
+    /**
+     * @brief Returns a new expression extended by a child. The child can be
+     * anything VBox and HBox accept, or a nested expression. Nothing is
+     * created until the outermost expression is created, so its result must
+     * not be discarded.
+     */
+    template<typename Item_T>
+    [[nodiscard]] BoxExpr<Direction_T, Items_T..., typename BoxExprItem<Item_T>::type>
+    operator<<(Item_T &&item) &&
+    {
+        using Stored = typename BoxExprItem<Item_T>::type;
+        m_pending = false;
+        return BoxExpr<Direction_T, Items_T..., Stored>(
+            m_parent, m_margins, m_spacing,
+            std::tuple_cat(std::move(m_items), std::tuple<Stored>(std::forward<Item_T>(item))));
+    }
+
+    /**
+     * @brief Creates the layouts. See create().
+     */
+    operator Layout_T *() { return create(); }
+
+    /**
+     * @brief Creates the layout hierarchy captured by the expression in one
+     * depth-first pass and installs it to the parent widget (if any). Each
+     * call creates new layouts, so the expression should be converted only
+     * once.
+     */
+    Layout_T *create()
+    {
+        m_pending = false;
+        Layout_T *layout = nullptr;
+        if constexpr (std::is_same<Layout_T, QBoxLayout>::value) {
+            layout = new QBoxLayout(Direction_T);
+        } else {
+            layout = new Layout_T();
+        }
+        layout->setContentsMargins(m_margins.margins());
+        layout->setSpacing(m_spacing.spacing());
+
+        std::apply([layout](auto &...items) { (addItem(layout, items), ...); }, m_items);
+
+        if (m_parent) {
+            m_parent->setLayout(layout);
+        }
+        return layout;
+    }
+
+    /**
+     * @brief Returns true if the expression has no children, not counting
+     * nullptr widgets and layouts and empty nested expressions.
+     */
+    bool isEmpty() const
+    {
+        return std::apply([](const auto &...items) { return (isEmptyItem(items) && ...); },
+                          m_items);
+    }
+
+private:
+    template<QBoxLayout::Direction, typename...>
+    friend class BoxExpr;
+
+    BoxExpr(QWidget *parent, const Margins &margins, Spacing spacing, std::tuple<Items_T...> &&items)
+        : m_parent(parent)
+        , m_margins(margins)
+        , m_spacing(spacing)
+        , m_items(std::move(items))
+    {
+        // Nested expressions are created or skipped by this one.
+        std::apply([](auto &...stored) { (release(stored), ...); }, m_items);
+    }
+
+    template<typename T>
+    static void release(T &)
+    {}
+
+    template<QBoxLayout::Direction D, typename... I>
+    static void release(BoxExpr<D, I...> &expr)
+    {
+        expr.m_pending = false;
+    }
+
+    static bool isEmptyItem(QWidget *widget) { return !widget; }
+
+    static bool isEmptyItem(QLayout *layout) { return !layout; }
+
+    static bool isEmptyItem(const Stretch &) { return false; }
+
+    static bool isEmptyItem(const Stretched &stretched)
+    {
+        return !stretched.widget() && !stretched.layout();
+    }
+
+    static bool isEmptyItem(const Aligned &aligned) { return !aligned.widget(); }
+
+    static bool isEmptyItem(Spacing spacing) { return spacing.spacing() <= 0; }
+
+    template<QBoxLayout::Direction D, typename... I>
+    static bool isEmptyItem(const BoxExpr<D, I...> &expr)
+    {
+        return expr.isEmpty();
+    }
+
+    static void addItem(QBoxLayout *layout, QWidget *widget)
+    {
+        if (widget) {
+            layout->addWidget(widget);
+        }
+    }
+
+    static void addItem(QBoxLayout *layout, QLayout *child)
+    {
+        if (child) {
+            layout->addLayout(child);
+        }
+    }
+
+    static void addItem(QBoxLayout *layout, const Stretch &stretch)
+    {
+        layout->addStretch(stretch.stretch());
+    }
+
+    static void addItem(QBoxLayout *layout, const Stretched &stretched)
+    {
+        if (stretched.widget()) {
+            layout->addWidget(stretched.widget(), stretched.stretch());
+        } else if (stretched.layout()) {
+            layout->addLayout(stretched.layout(), stretched.stretch());
+        }
+    }
+
+    static void addItem(QBoxLayout *layout, const Aligned &aligned)
+    {
+        if (aligned.widget()) {
+            layout->addWidget(aligned.widget(), aligned.stretch(), aligned.alignment());
+        }
+    }
+
+    static void addItem(QBoxLayout *layout, Spacing spacing)
+    {
+        if (spacing.spacing() > 0) {
+            layout->addSpacing(spacing.spacing());
+        }
+    }
+
+    template<QBoxLayout::Direction D, typename... I>
+    static void addItem(QBoxLayout *layout, BoxExpr<D, I...> &expr)
+    {
+        if (!expr.isEmpty()) {
+            layout->addLayout(expr.create());
+        }
+    }
+
+    QWidget *m_parent = nullptr;
+    Margins m_margins;
+    Spacing m_spacing;
+    std::tuple<Items_T...> m_items;
+    bool m_pending = true;
+};
+
+/**
+ * @brief Expression-template counterpart of VBox.
+ */
+using VBoxExpr = BoxExpr<QBoxLayout::TopToBottom>;
+
+/**
+ * @brief Expression-template counterpart of HBox.
+ */
+using HBoxExpr = BoxExpr<QBoxLayout::LeftToRight>;
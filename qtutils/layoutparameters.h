@@ -0,0 +1,84 @@
+#pragma once
+
+#include <QMargins>
+
+//
+// Margins, spacing and stretch descriptors shared by the layout wrappers in
+// layouts.h and by the widget-free GeometryBox, which does not need the
+// wrappers themselves.
+//
+
+/**
+ * @brief Defines margins for layout wrappers. By default, all layout wrappers
+ * have zero-sized margins. Non-zero sized margins are however needed for
+ * top-level layouts in a window or dialog. Use default constructor Margins()
+ * to create default margins, i.e. depending on application's QStyle. Default
+ * margins correspond to value -1.
+ */
+class Margins final
+{
+public:
+    /**
+     * @brief Uses the same margin size for all left, top, right and bottom
+     * margins. Default value -1 means that the margins are inherited from
+     * outer parent layouts or are defined by the current style if there is
+     * no outer layout.
+     */
+    explicit Margins(int value = -1)
+        : m_margins(value, value, value, value)
+    {}
+
+    Margins(int left, int top, int right, int bottom)
+        : m_margins(left, top, right, bottom)
+    {}
+
+    Margins(const QMargins &margins)
+        : m_margins(margins)
+    {}
+
+    const QMargins &margins() const { return m_margins; }
+
+private:
+    QMargins m_margins;
+};
+
+/**
+ * @brief Defines spacing for layout wrappers.
+ */
+class Spacing final
+{
+public:
+    /**
+     * @brief Default value -1 means that the spacing is inherited from
+     * outer parent layouts or is defined by the current style if there
+     * is no outer layout.
+     */
+    explicit Spacing(int spacing = -1)
+        : m_spacing(spacing)
+    {}
+
+    int spacing() const { return m_spacing; }
+
+private:
+    int m_spacing;
+};
+
+/**
+ * @brief Allows placing stretched blank space into parent VBox or HBox
+ * layouts.
+ */
+class Stretch final
+{
+public:
+    /**
+     * @brief Stretched blank space.
+     */
+    explicit Stretch(int stretch = 1)
+        : m_stretch(stretch)
+    {}
+
+    int stretch() const { return m_stretch; }
+
+private:
+    int m_stretch;
+};
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QHash>
+#include <QLayout>
+#include <QPointer>
+#include <QVector>
+#include <QWidget>
+
+#include <algorithm>
+#include <utility>
+
+/**
+ * @brief Opt-in profiler of layouts created by layout wrappers. When enabled,
+ * layout wrappers create instrumented layouts, which count and time their
+ * setGeometry() calls. Layout activations, i.e. the processing of
+ * QEvent::LayoutRequest by top-level layouts, are counted and timed as well.
+ * The statistics are collected per layout name, which is the object name of
+ * the layout. Unnamed layouts are named after their class and the class and
+ * object name of their parent widget. Statistics of destroyed layouts are
+ * kept, so layouts of dialogs which are opened repeatedly are summed.
+ *
+ * The profiler must be enabled before the layouts to be profiled are
+ * created. It is meant to be used from the GUI thread only:
+ *
+ * LayoutProfiler::setEnabled(true);
+ * ...
+ * VBox(dialog) << ...;
+ * dialog->layout()->setObjectName("settings");
+ * ...
+ * LayoutProfiler::dump();
+ */
+class LayoutProfiler final
+{
+public:
+    /**
+     * @brief Statistics of one layout name. Times are in nanoseconds.
+     * Activation time includes the setGeometry() calls of the whole layout
+     * hierarchy done during the activation.
+     */
+    struct Stats
+    {
+        QString name;
+        int activations = 0;
+        qint64 activationTime = 0;
+        int geometryUpdates = 0;
+        qint64 geometryTime = 0;
+    };
+
+    /**
+     * @brief Enables or disables creation of instrumented layouts and
+     * counting of layout activations. Disabled by default.
+     */
+    static void setEnabled(bool enabled)
+    {
+        s_enabled = enabled;
+        if (!enabled) {
+            delete s_activationFilter;
+        }
+    }
+
+    static bool isEnabled() { return s_enabled; }
+
+    /**
+     * @brief Returns the statistics of all profiled layouts, sorted by total
+     * time spent in activations and setGeometry() calls, descending.
+     */
+    static QVector<Stats> statistics()
+    {
+        QHash<QString, Stats> byName = s_finished;
+        for (auto it = s_live.cbegin(); it != s_live.cend(); ++it) {
+            merge(byName, nameOf(it.key()), it.value());
+        }
+
+        QVector<Stats> result;
+        result.reserve(byName.size());
+        for (auto it = byName.cbegin(); it != byName.cend(); ++it) {
+            result.append(it.value());
+            result.last().name = it.key();
+        }
+        std::sort(result.begin(), result.end(), [](const Stats &a, const Stats &b) {
+            return a.activationTime + a.geometryTime > b.activationTime + b.geometryTime;
+        });
+        return result;
+    }
+
+    /**
+     * @brief Writes the statistics to the debug output, one line per layout
+     * name.
+     */
+    static void dump()
+    {
+        qInfo("%-40s %12s %12s %12s %12s", "layout", "activations", "time [us]",
+              "geometry", "time [us]");
+        for (const Stats &stats : statistics()) {
+            qInfo("%-40s %12d %12lld %12d %12lld", qPrintable(stats.name), stats.activations,
+                  stats.activationTime / 1000, stats.geometryUpdates, stats.geometryTime / 1000);
+        }
+    }
+
+    /**
+     * @brief Clears the statistics of all layouts.
+     */
+    static void reset()
+    {
+        s_finished.clear();
+        for (auto it = s_live.begin(); it != s_live.end(); ++it) {
+            it.value() = Stats();
+        }
+    }
+
+    /**
+     * @brief Registers an instrumented layout. Called by ProfiledLayout.
+     */
+    static void attach(QLayout *layout)
+    {
+        if (!s_activationFilter && qApp) {
+            s_activationFilter = new ActivationFilter(qApp);
+            qApp->installEventFilter(s_activationFilter);
+        }
+        s_live.insert(layout, Stats());
+    }
+
+    /**
+     * @brief Moves the statistics of a destroyed instrumented layout to the
+     * statistics of its name. Called by ProfiledLayout.
+     */
+    static void detach(QLayout *layout)
+    {
+        const auto it = s_live.find(layout);
+        if (it != s_live.end()) {
+            merge(s_finished, nameOf(layout), it.value());
+            s_live.erase(it);
+        }
+    }
+
+    static void recordGeometry(QLayout *layout, qint64 time)
+    {
+        const auto it = s_live.find(layout);
+        if (it != s_live.end()) {
+            ++it->geometryUpdates;
+            it->geometryTime += time;
+        }
+    }
+
+private:
+    /**
+     * @brief Application-wide event filter, which activates instrumented
+     * top-level layouts itself when their widget receives LayoutRequest.
+     * Application event filters are called before QLayout::widgetEvent(),
+     * which then finds the layout already activated. Created with the first
+     * instrumented layout as a child of the application, so no QObject
+     * outlives the application.
+     */
+    class ActivationFilter final : public QObject
+    {
+    public:
+        using QObject::QObject;
+
+        bool eventFilter(QObject *watched, QEvent *event) override
+        {
+            if (event->type() == QEvent::LayoutRequest && watched->isWidgetType()) {
+                auto widget = static_cast<QWidget *>(watched);
+                QLayout *layout = widget->layout();
+                const auto it = s_live.find(layout);
+                if (it != s_live.end() && widget->isVisible()) {
+                    QElapsedTimer timer;
+                    timer.start();
+                    layout->activate();
+                    // Activation may destroy the layout in rare cases
+                    // (e.g. deleteLater() processed by a nested event loop).
+                    const auto current = s_live.find(layout);
+                    if (current != s_live.end()) {
+                        ++current->activations;
+                        current->activationTime += timer.nsecsElapsed();
+                    }
+                }
+            }
+            return false;
+        }
+    };
+
+    static QString nameOf(const QLayout *layout)
+    {
+        if (!layout->objectName().isEmpty()) {
+            return layout->objectName();
+        }
+        QString name = QString::fromLatin1(layout->metaObject()->className());
+        if (QWidget *widget = layout->parentWidget()) {
+            name += QStringLiteral(" in ") + QString::fromLatin1(widget->metaObject()->className());
+            if (!widget->objectName().isEmpty()) {
+                name += QStringLiteral(" ") + widget->objectName();
+            }
+        }
+        return name;
+    }
+
+    static void merge(QHash<QString, Stats> &byName, const QString &name, const Stats &stats)
+    {
+        Stats &target = byName[name];
+        target.activations += stats.activations;
+        target.activationTime += stats.activationTime;
+        target.geometryUpdates += stats.geometryUpdates;
+        target.geometryTime += stats.geometryTime;
+    }
+
+    inline static bool s_enabled = false;
+    inline static QHash<const QLayout *, Stats> s_live;
+    inline static QHash<QString, Stats> s_finished;
+    inline static QPointer<ActivationFilter> s_activationFilter;
+};
+
+/**
+ * @brief Layout instrumented by LayoutProfiler. Layout wrappers create it
+ * instead of Layout_T when the profiler is enabled.
+ */
+template<typename Layout_T>
+class ProfiledLayout final : public Layout_T
+{
+public:
+    template<typename... Args_T>
+    explicit ProfiledLayout(Args_T &&...args)
+        : Layout_T(std::forward<Args_T>(args)...)
+    {
+        LayoutProfiler::attach(this);
+    }
+
+    ~ProfiledLayout() override { LayoutProfiler::detach(this); }
+
+    void setGeometry(const QRect &rect) override
+    {
+        QElapsedTimer timer;
+        timer.start();
+        Layout_T::setGeometry(rect);
+        LayoutProfiler::recordGeometry(this, timer.nsecsElapsed());
+    }
+};
@@ -1,15 +1,40 @@
 #pragma once
 
+#include <QApplication>
 #include <QFormLayout>
+#include <QGridLayout>
 #include <QHBoxLayout>
+#include <QHash>
+#include <QLabel>
 #include <QMargins>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QPointer>
+#include <QSet>
+#include <QStackedLayout>
+#include <QStyle>
+#include <QTabWidget>
+#include <QTimer>
+#include <QVector>
 #include <QVBoxLayout>
 #include <QWidget>
 
+#include <functional>
+#include <memory>
+#include <typeinfo>
+#include <utility>
+
+#include "geometrycache.h"
+#include "layoutparameters.h"
+#include "layoutprofiler.h"
+#include "linearlayout.h"
+#include "resizecoalescing.h"
+#include "stylemetrics.h"
+
 //
-// Simple wrappers around QVBoxLayout, QHBoxLayout and QFormLayout, which allow
-// easy to read and easy to maintain "declarative" style of creating layouts in
-// your QtWidgets code. It also supports simple setting of margins, spacing,
+// Simple wrappers around QVBoxLayout, QHBoxLayout, QFormLayout and QGridLayout,
+// which allow easy to read and easy to maintain "declarative" style of creating
+// layouts in your QtWidgets code. It also supports simple setting of margins, spacing,
 // stretch and alignment.
 //
 // The main advantage is that defining complex hierarchical layouts can be done
@@ -90,139 +115,286 @@
 //     << buttonB;
 //
 
+//
+// When a layout receives hundreds of children, each insertion invalidates the
+// layout and may trigger a repaint of its widget. In batched mode the wrapper
+// only collects the children and defers their insertion until it is converted
+// to the layout pointer or the last copy of the wrapper goes out of scope. The
+// children are then inserted one after another with the layout disabled and
+// updates of its widget suppressed, so no layout pass or repaint runs between
+// them:
+//
+// auto box = VBox(dialog).setBatched(true);
+// for (auto row : rows) {
+//     box << row;
+// }
+// box.commit();
+//
+
+//
+// Pages of Stack and Tabs can be Lazy, so that they are constructed only the
+// first time they become current. With prefetching, the page following the
+// current one is constructed when the event loop becomes idle, so it is
+// usually ready before the user switches to it:
+//
+// VBox(dialog, Margins())
+//     << (Tabs().setPrefetching(true)
+//         << Tab(tr("General"), Lazy<GeneralPage>())
+//         << Tab(tr("Network"), Lazy<NetworkPage>())
+//         << Tab(tr("Advanced"), Lazy<AdvancedPage>()))
+//     << buttons;
+//
+
 /**
- * @brief Defines margins for layout wrappers. By default, all layout wrappers
- * have zero-sized margins. Non-zero sized margins are however needed for
- * top-level layouts in a window or dialog. Use default constructor Margins()
- * to create default margins, i.e. depending on application's QStyle. Default
- * margins correspond to value -1.
+ * @brief Allows placing stretched child widget or layout into parent VBox or
+ * HBox layouts.
  */
-class Margins final
+class Stretched final
 {
 public:
     /**
-     * @brief Uses the same margin size for all left, top, right and bottom
-     * margins. Default value -1 means that the margins are inherited from
-     * outer parent layouts or are defined by the current style if there is
-     * no outer layout.
+     * @brief Wraps a stretched widget.
      */
-    explicit Margins(int value = -1)
-        : m_margins(value, value, value, value)
+    explicit Stretched(QWidget *widget, int stretch = 1)
+        : m_widget(widget)
+        , m_stretch(stretch)
     {}
 
-    Margins(int left, int top, int right, int bottom)
-        : m_margins(left, top, right, bottom)
+    /**
+     * @brief Wraps a stretched child layout.
+     */
+    explicit Stretched(QLayout *layout, int stretch = 1)
+        : m_layout(layout)
+        , m_stretch(stretch)
     {}
 
-    Margins(const QMargins &margins)
-        : m_margins(margins)
-    {}
+    QWidget *widget() const { return m_widget; }
+
+    QLayout *layout() const { return m_layout; }
 
-    const QMargins &margins() const { return m_margins; }
+    int stretch() const { return m_stretch; }
 
 private:
-    QMargins m_margins;
+    QWidget *m_widget = nullptr;
+    QLayout *m_layout = nullptr;
+    int m_stretch;
 };
 
 /**
- * @brief Defines spacing for layout wrappers.
+ * @brief Allows placing aligned and (optionally) stretched widget into parent
+ * VBox or HBox layouts.
  */
-class Spacing final
+class Aligned final
 {
 public:
-    /**
-     * @brief Default value -1 means that the spacing is inherited from
-     * outer parent layouts or is defined by the current style if there
-     * is no outer layout.
-     */
-    explicit Spacing(int spacing = -1)
-        : m_spacing(spacing)
+    Aligned(QWidget *widget, Qt::Alignment alignment, int stretch = 0)
+        : m_widget(widget)
+        , m_alignment(alignment)
+        , m_stretch(stretch)
     {}
 
-    int spacing() const { return m_spacing; }
+    QWidget *widget() const { return m_widget; }
+
+    Qt::Alignment alignment() const { return m_alignment; }
+
+    int stretch() const { return m_stretch; }
 
 private:
-    int m_spacing;
+    QWidget *m_widget = nullptr;
+    Qt::Alignment m_alignment;
+    int m_stretch;
 };
 
 /**
- * @brief Allows placing stretched blank space into parent VBox or HBox
- * layouts.
+ * @brief Placeholder widget which creates its content using a factory the
+ * first time it becomes visible. Until then it is an empty widget without
+ * any children or layout. Use Lazy to place it into layout wrappers.
  */
-class Stretch final
+class LazyWidget : public QWidget
 {
 public:
+    explicit LazyWidget(std::function<QWidget *()> factory, QWidget *parent = nullptr)
+        : QWidget(parent)
+        , m_factory(std::move(factory))
+    {}
+
     /**
-     * @brief Stretched blank space.
+     * @brief Returns the content widget or nullptr if it was not created yet.
      */
-    explicit Stretch(int stretch = 1)
-        : m_stretch(stretch)
-    {}
+    QWidget *content() const { return m_content; }
 
-    int stretch() const { return m_stretch; }
+    bool isMaterialized() const { return !m_factory; }
+
+    /**
+     * @brief Creates the content widget now (if not created yet) and returns
+     * it.
+     */
+    QWidget *materialize()
+    {
+        if (m_factory) {
+            auto factory = std::move(m_factory);
+            m_factory = nullptr;
+            m_content = factory();
+            if (m_content) {
+                auto layout = new QVBoxLayout(this);
+                layout->setContentsMargins(0, 0, 0, 0);
+                layout->addWidget(m_content);
+            }
+        }
+        return m_content;
+    }
+
+    /**
+     * @brief Materializes the page in a later event loop iteration, after
+     * the pending events are processed, if it is a LazyWidget which is not
+     * materialized yet. Used to prefetch pages of Stack and Tabs.
+     */
+    static void materializeLater(QWidget *page)
+    {
+        auto lazy = dynamic_cast<LazyWidget *>(page);
+        if (lazy && !lazy->isMaterialized()) {
+            QTimer::singleShot(0, lazy, [lazy] { lazy->materialize(); });
+        }
+    }
+
+protected:
+    void showEvent(QShowEvent *event) override
+    {
+        materialize();
+        QWidget::showEvent(event);
+    }
 
 private:
-    int m_stretch;
+    std::function<QWidget *()> m_factory;
+    QWidget *m_content = nullptr;
 };
 
 /**
- * @brief Allows placing stretched child widget or layout into parent VBox or
- * HBox layouts.
+ * @brief Reserves a slot for a widget of type T which is created by a factory
+ * only when the slot becomes visible for the first time. The slot converts
+ * to its placeholder widget, so it can be added to any layout wrapper, used
+ * in Stretched, Aligned or Row etc. If no factory is given, the widget is
+ * created by the default constructor of T. Example:
+ *
+ * auto history = Lazy<HistoryPanel>();
+ * history.slot()->hide();
+ *
+ * HBox(window)
+ *     << editor
+ *     << history;
+ *
+ * // later, HistoryPanel is constructed here
+ * history.slot()->show();
  */
-class Stretched final
+template<typename T = QWidget>
+class Lazy final
 {
 public:
-    /**
-     * @brief Wraps a stretched widget.
-     */
-    explicit Stretched(QWidget *widget, int stretch = 1)
-        : m_widget(widget)
-        , m_stretch(stretch)
+    explicit Lazy(std::function<T *()> factory = [] { return new T(); })
+        : m_slot(new LazyWidget(std::move(factory)))
     {}
 
     /**
-     * @brief Wraps a stretched child layout.
+     * @brief Implicit conversion to the placeholder widget.
      */
-    explicit Stretched(QLayout *layout, int stretch = 1)
-        : m_layout(layout)
-        , m_stretch(stretch)
-    {}
+    operator LazyWidget *() const { return m_slot; }
 
-    QWidget *widget() const { return m_widget; }
+    /**
+     * @brief Returns the placeholder widget, which can be shown or hidden.
+     */
+    LazyWidget *slot() const { return m_slot; }
 
-    QLayout *layout() const { return m_layout; }
+    /**
+     * @brief Returns the widget or nullptr if it was not created yet.
+     */
+    T *widget() const { return static_cast<T *>(m_slot->content()); }
 
-    int stretch() const { return m_stretch; }
+    /**
+     * @brief Returns the widget, creates it if it was not created yet.
+     */
+    T *get() const { return static_cast<T *>(m_slot->materialize()); }
 
 private:
-    QWidget *m_widget = nullptr;
-    QLayout *m_layout = nullptr;
-    int m_stretch;
+    LazyWidget *m_slot;
 };
 
 /**
- * @brief Allows placing aligned and (optionally) stretched widget into parent
- * VBox or HBox layouts.
+ * @brief Bundles the construction of a widget of type T with the setters
+ * configuring it. The widget is created and configured in one go when the
+ * builder is converted to the widget, i.e. when it is added to a layout
+ * wrapper, used in Stretched, Aligned or Row etc. At that point the widget
+ * has no parent, so the setters do not invalidate any layout. The factory
+ * and the setters must not polish the widget (e.g. by querying its size
+ * hint), which is asserted in debug builds, so the style polishes the
+ * configured widget when it is shown rather than polishing it again after
+ * each setter which changes the style. If no factory is given, the widget is
+ * created by the default constructor of T. Example:
+ *
+ * Form(dialog)
+ *     << Row(tr("Name"), Build<QLineEdit>()
+ *                            .set(&QLineEdit::setPlaceholderText, tr("First and last name"))
+ *                            .set(&QLineEdit::setMaxLength, 80))
+ *     << Row(tr("Notes"), Build<QTextEdit>().with([](QTextEdit *edit) {
+ *            edit->setAcceptRichText(false);
+ *            edit->setTabChangesFocus(true);
+ *        }));
  */
-class Aligned final
+template<typename T>
+class Build final
 {
 public:
-    Aligned(QWidget *widget, Qt::Alignment alignment, int stretch = 0)
-        : m_widget(widget)
-        , m_alignment(alignment)
-        , m_stretch(stretch)
+    explicit Build(std::function<T *()> factory = [] { return new T(); })
+        : m_factory(std::move(factory))
     {}
 
-    QWidget *widget() const { return m_widget; }
+    /**
+     * @brief Adds a call of the setter with the given arguments, which are
+     * stored by value until the widget is built.
+     */
+    template<typename Class_T, typename... Params_T, typename... Args_T>
+    Build &set(void (Class_T::*setter)(Params_T...), Args_T &&...args)
+    {
+        m_steps.append([setter, args...](T *widget) { (widget->*setter)(args...); });
+        return *this;
+    }
 
-    Qt::Alignment alignment() const { return m_alignment; }
+    /**
+     * @brief Adds a function which configures the widget.
+     */
+    Build &with(std::function<void(T *)> step)
+    {
+        m_steps.append(std::move(step));
+        return *this;
+    }
 
-    int stretch() const { return m_stretch; }
+    /**
+     * @brief Implicit conversion to the widget, builds it if it was not built
+     * yet.
+     */
+    operator T *() const { return get(); }
+
+    /**
+     * @brief Returns the widget, builds it if it was not built yet.
+     */
+    T *get() const
+    {
+        if (!m_widget) {
+            m_widget = m_factory();
+            Q_ASSERT_X(!m_widget->testAttribute(Qt::WA_WState_Polished), "Build",
+                       "the factory returned a polished widget");
+            for (const auto &step : m_steps) {
+                step(m_widget);
+            }
+            Q_ASSERT_X(!m_widget->testAttribute(Qt::WA_WState_Polished), "Build",
+                       "a setter polished the widget");
+        }
+        return m_widget;
+    }
 
 private:
-    QWidget *m_widget = nullptr;
-    Qt::Alignment m_alignment;
-    int m_stretch;
+    std::function<T *()> m_factory;
+    QVector<std::function<void(T *)>> m_steps;
+    mutable T *m_widget = nullptr;
 };
 
 /**
@@ -238,6 +410,9 @@ public:
     {
         p->setContentsMargins(margins.margins());
         p->setSpacing(spacing.spacing());
+        if (StyleMetrics::isEnabled()) {
+            StyleMetrics::adopt(p, margins.margins(), spacing.spacing());
+        }
     }
 
     /**
@@ -253,6 +428,44 @@ public:
      */
     Layout_T *operator->() const { return p; }
 
+protected:
+    /**
+     * @brief Creates a layout of class T with the parent widget. Top-level
+     * layouts get a geometry cache if GeometryCache is enabled and coalesce
+     * resizes if ResizeCoalescing is enabled. Layouts are instrumented if
+     * LayoutProfiler is enabled and are named by their object name in the
+     * profiler's statistics, e.g. wrapper->setObjectName("settings").
+     */
+    template<typename T, typename... Args_T>
+    static T *createLayout(QWidget *parent, Args_T &&...args)
+    {
+        if (parent && GeometryCache::isEnabled()) {
+            return createCoalescingLayout<CachedLayout<T>>(parent, std::forward<Args_T>(args)...);
+        }
+        return createCoalescingLayout<T>(parent, std::forward<Args_T>(args)...);
+    }
+
+private:
+    template<typename T, typename... Args_T>
+    static T *createCoalescingLayout(QWidget *parent, Args_T &&...args)
+    {
+        // Coalescing wraps the cache, so that only the passes which are
+        // actually done are cached.
+        if (parent && ResizeCoalescing::isEnabled()) {
+            return createProfiledLayout<CoalescingLayout<T>>(parent, std::forward<Args_T>(args)...);
+        }
+        return createProfiledLayout<T>(parent, std::forward<Args_T>(args)...);
+    }
+
+    template<typename T, typename... Args_T>
+    static T *createProfiledLayout(QWidget *parent, Args_T &&...args)
+    {
+        if (LayoutProfiler::isEnabled()) {
+            return new ProfiledLayout<T>(std::forward<Args_T>(args)..., parent);
+        }
+        return new T(std::forward<Args_T>(args)..., parent);
+    }
+
 protected:
     Layout_T *p = nullptr;
 };
@@ -264,17 +477,72 @@ protected:
 class Box : public LayoutWraper<QBoxLayout>
 {
 public:
+    /**
+     * @brief Layout engines which can be used by VBox and HBox wrappers.
+     * Qt uses QVBoxLayout and QHBoxLayout, Caching uses LinearLayout, which
+     * caches the item sizes and distributes space without allocations.
+     */
+    enum class Engine { Qt, Caching };
+
     Box(QBoxLayout *layout, const Margins &margins, Spacing spacing)
         : LayoutWraper<QBoxLayout>(layout, margins, spacing)
     {}
 
+    /**
+     * @brief Sets the engine of layouts created by VBox and HBox wrappers
+     * from now on. Default is Engine::Qt. Note that with Engine::Caching the
+     * wrapped layouts are not QVBoxLayout and QHBoxLayout instances, but
+     * LinearLayout instances (inheriting QBoxLayout).
+     */
+    static void setDefaultEngine(Engine engine) { s_defaultEngine = engine; }
+
+    static Engine defaultEngine() { return s_defaultEngine; }
+
+    /**
+     * @brief Enables or disables flattening of nested layouts. When enabled,
+     * a child layout added to a Box is spliced into it instead of being
+     * nested, if it is a VBox or HBox (or plain QBoxLayout) in the same
+     * direction, with zero margins, default spacing and no alignment. The
+     * child layout is deleted, so it must not be used after it is added,
+     * which is the usual case of nested wrapper expressions like
+     * VBox() << (VBox() << a << b) << c. Disabled by default.
+     */
+    static void setFlatteningEnabled(bool value) { s_flattening = value; }
+
+    static bool isFlatteningEnabled() { return s_flattening; }
+
+    /**
+     * @brief Returns the number of layouts eliminated by flattening so far.
+     */
+    static int flattenedLayoutCount() { return s_flattenedLayoutCount; }
+
+    /**
+     * @brief Implicit conversion to the wrapped layout. Pending children of
+     * a batched wrapper are committed before the layout is handed out.
+     */
+    operator QBoxLayout *() const
+    {
+        commit();
+        return p;
+    }
+
+    /**
+     * @brief Dereference operator can be used to access methods of the wrapped
+     * layout. Pending children of a batched wrapper are committed first.
+     */
+    QBoxLayout *operator->() const
+    {
+        commit();
+        return p;
+    }
+
     /**
      * @brief Adds a child widget. If the widget is null, it will be ignored.
      */
     Box &operator<<(QWidget *widget)
     {
         if (widget) {
-            p->insertWidget(placement(), widget);
+            add(Item::fromWidget(widget));
         }
 
         return *this;
@@ -287,8 +555,8 @@ public:
      */
     Box &operator<<(QLayout *layout)
     {
-        if (layout) {
-            p->insertLayout(placement(), layout);
+        if (layout && !flatten(layout)) {
+            add(Item::fromLayout(layout));
         }
 
         return *this;
@@ -299,7 +567,7 @@ public:
      */
     Box &operator<<(const Stretch &stretch)
     {
-        p->insertStretch(placement(), stretch.stretch());
+        add(Item::fromStretch(stretch.stretch()));
         return *this;
     }
 
@@ -309,9 +577,9 @@ public:
     Box &operator<<(const Stretched &stretched)
     {
         if (stretched.widget()) {
-            p->insertWidget(placement(), stretched.widget(), stretched.stretch());
+            add(Item::fromWidget(stretched.widget(), stretched.stretch()));
         } else if (stretched.layout()) {
-            p->insertLayout(placement(), stretched.layout(), stretched.stretch());
+            add(Item::fromLayout(stretched.layout(), stretched.stretch()));
         }
         return *this;
     }
@@ -322,7 +590,7 @@ public:
     Box &operator<<(const Aligned &aligned)
     {
         if (aligned.widget()) {
-            p->insertWidget(placement(), aligned.widget(), aligned.stretch(), aligned.alignment());
+            add(Item::fromWidget(aligned.widget(), aligned.stretch(), aligned.alignment()));
         }
         return *this;
     }
@@ -333,94 +601,567 @@ public:
     Box &operator<<(Spacing spacing)
     {
         if (spacing.spacing() > 0) {
-            p->insertSpacing(placement(), spacing.spacing());
+            add(Item::fromSpacing(spacing.spacing()));
         }
         return *this;
     }
 
+    /**
+     * @brief In reversed mode each new child is placed in front of the
+     * children added before it. Reversed wrappers are always batched, the
+     * buffered children are inserted once in their final order, which keeps
+     * the construction linear in the number of children. Switching reversed
+     * mode off commits the pending children and returns to the batched mode
+     * set by setBatched().
+     */
     Box &setReversed(bool value)
     {
         m_reversed = value;
+        updateBatch();
         return *this;
     }
 
     bool isReversed() const { return m_reversed; }
 
-protected:
-    int placement() const
+    /**
+     * @brief In batched mode children are not inserted into the wrapped
+     * layout as they are added. They are collected into a list of lightweight
+     * item descriptors instead and inserted later, with the layout disabled
+     * and updates of the parent widget suppressed. Each child is still
+     * inserted (and reparented) separately, batching only defers the
+     * insertions and keeps layout passes and repaints from running between
+     * them. Pending children are committed when the wrapper is converted to
+     * the layout pointer, when commit() is called, when batched mode is
+     * switched off or when the last copy of the wrapper is destroyed. Note
+     * that the pending descriptors hold raw pointers, the children must not
+     * be deleted before the commit. If the layout is deleted first, the
+     * pending children are not inserted.
+     */
+    Box &setBatched(bool value)
     {
-        // 0 .. insert at the first position
-        // -1 .. insert at the last position
-        return m_reversed ? 0 : -1;
+        m_batched = value;
+        updateBatch();
+        return *this;
     }
 
-    bool m_reversed = false;
-};
+    /**
+     * @brief Returns true if children are batched, either because batched
+     * mode was set or because the wrapper is reversed.
+     */
+    bool isBatched() const { return m_batch != nullptr; }
 
-/**
- * @brief Layout wrapper for QVBoxLayout.
- */
-class VBox : public Box
-{
-public:
-    explicit VBox(QWidget *parent,
-                  const Margins &margins = Margins(0),
-                  Spacing spacing = Spacing(-1))
-        : Box(new QVBoxLayout(parent), margins, spacing)
-    {}
+    /**
+     * @brief Inserts all pending children of a batched wrapper into the
+     * wrapped layout. Does nothing if the wrapper is not batched.
+     */
+    void commit() const
+    {
+        if (m_batch) {
+            m_batch->commit();
+        }
+    }
 
-    explicit VBox(const Margins &margins, Spacing spacing = Spacing(-1))
-        : VBox(nullptr, margins, spacing)
-    {}
+protected:
+    /**
+     * @brief Descriptor of a single child item. Value is the stretch factor
+     * for widgets, layouts and stretches, or the size for spacings.
+     */
+    struct Item
+    {
+        enum Kind { WidgetItem, LayoutItem, StretchItem, SpacingItem, OtherItem };
 
-    explicit VBox(Spacing spacing = Spacing(-1))
-        : VBox(nullptr, Margins(0), spacing)
-    {}
-};
+        static Item fromWidget(QWidget *widget, int stretch = 0, Qt::Alignment alignment = {})
+        {
+            return { WidgetItem, widget, nullptr, nullptr, stretch, alignment, false };
+        }
 
-/**
- * @brief Layout wrapper for QHBoxLayout.
- */
-class HBox : public Box
-{
-public:
-    explicit HBox(QWidget *parent,
-                  const Margins &margins = Margins(0),
-                  Spacing spacing = Spacing(-1))
-        : Box(new QHBoxLayout(parent), margins, spacing)
-    {}
+        static Item fromLayout(QLayout *layout, int stretch = 0)
+        {
+            return { LayoutItem, nullptr, layout, nullptr, stretch, {}, false };
+        }
 
-    explicit HBox(const Margins &margins, Spacing spacing = Spacing(-1))
-        : HBox(nullptr, margins, spacing)
-    {}
+        static Item fromStretch(int stretch)
+        {
+            return { StretchItem, nullptr, nullptr, nullptr, stretch, {}, false };
+        }
 
-    explicit HBox(Spacing spacing = Spacing(-1))
-        : HBox(nullptr, Margins(0), spacing)
-    {}
-};
+        static Item fromSpacing(int size)
+        {
+            return { SpacingItem, nullptr, nullptr, nullptr, size, {}, false };
+        }
 
-/**
- * @brief Wrapper of items to be added in a single row to a Form layout wrapper.
- */
-class Row final
-{
-public:
-    Row(QWidget *label, QWidget *widget)
-        : m_label(label)
-        , m_widget(widget)
-    {}
+        static Item fromLayoutItem(QLayoutItem *item, int stretch)
+        {
+            return { OtherItem, nullptr, nullptr, item, stretch, {}, false };
+        }
 
-    Row(const QString &labelText, QWidget *widget)
-        : m_labelText(labelText)
-        , m_widget(widget)
-    {}
+        Kind kind;
+        QWidget *widget;
+        QLayout *layout;
+        QLayoutItem *item;
+        int value;
+        Qt::Alignment alignment;
+        bool front;
+    };
 
-    Row(QWidget *label, QLayout *layout)
-        : m_label(label)
-        , m_layout(layout)
-    {}
+    /**
+     * @brief Pending children of a batched wrapper. It is shared by all copies
+     * of the wrapper and commits the remaining children when destroyed,
+     * unless the layout was deleted in the meantime.
+     */
+    class Batch final
+    {
+    public:
+        explicit Batch(QBoxLayout *layout)
+            : m_layout(layout)
+        {}
 
-    Row(const QString &labelText, QLayout *layout)
+        ~Batch() { commit(); }
+
+        void append(const Item &item) { m_items.append(item); }
+
+        void commit()
+        {
+            if (m_items.isEmpty()) {
+                return;
+            }
+            if (!m_layout) {
+                m_items.clear();
+                return;
+            }
+
+            QWidget *parent = m_layout->parentWidget();
+            const bool updates = parent && parent->updatesEnabled();
+            const bool enabled = m_layout->isEnabled();
+            if (updates) {
+                parent->setUpdatesEnabled(false);
+            }
+            m_layout->setEnabled(false);
+
+            // Children added in reversed mode were pushed to the front, so they
+            // end up in front of the existing children in reverse order. The
+            // others are appended in the order in which they were added.
+            int front = 0;
+            for (auto it = m_items.crbegin(); it != m_items.crend(); ++it) {
+                if (it->front) {
+                    insert(m_layout, *it, front++);
+                }
+            }
+            for (const Item &item : qAsConst(m_items)) {
+                if (!item.front) {
+                    insert(m_layout, item, -1);
+                }
+            }
+            m_items.clear();
+
+            m_layout->setEnabled(enabled);
+            if (updates) {
+                parent->setUpdatesEnabled(true);
+            }
+            m_layout->invalidate();
+        }
+
+    private:
+        QPointer<QBoxLayout> m_layout;
+        QVector<Item> m_items;
+    };
+
+    void add(Item item)
+    {
+        item.front = m_reversed;
+        if (m_batch) {
+            m_batch->append(item);
+        } else {
+            insert(p, item, placement());
+        }
+    }
+
+    static void insert(QBoxLayout *layout, const Item &item, int index)
+    {
+        switch (item.kind) {
+        case Item::WidgetItem:
+            layout->insertWidget(index, item.widget, item.value, item.alignment);
+            break;
+        case Item::LayoutItem:
+            layout->insertLayout(index, item.layout, item.value);
+            break;
+        case Item::StretchItem:
+            layout->insertStretch(index, item.value);
+            break;
+        case Item::SpacingItem:
+            layout->insertSpacing(index, item.value);
+            break;
+        case Item::OtherItem:
+            layout->insertItem(index, item.item);
+            layout->setStretch(index < 0 ? layout->count() - 1 : index, item.value);
+            break;
+        }
+    }
+
+    /**
+     * @brief Splices the items of a child layout into this wrapper and
+     * deletes the child layout, if flattening is enabled and the child is
+     * a plain box layout in the same direction, which has no parent, zero
+     * margins, default spacing, no alignment and only plain widget items,
+     * i.e. no items replaced by features like size groups. Returns true if
+     * the child was flattened.
+     */
+    bool flatten(QLayout *layout)
+    {
+        if (!s_flattening) {
+            return false;
+        }
+
+        auto child = qobject_cast<QBoxLayout *>(layout);
+        if (!child || child == p || child->parent() || child->direction() != p->direction()
+            || !child->contentsMargins().isNull() || child->spacing() != -1 || child->alignment()
+            || child->sizeConstraint() != QLayout::SetDefaultConstraint
+            || (child->metaObject() != &QBoxLayout::staticMetaObject
+                && child->metaObject() != &QVBoxLayout::staticMetaObject
+                && child->metaObject() != &QHBoxLayout::staticMetaObject)) {
+            return false;
+        }
+        for (int i = 0; i < child->count(); ++i) {
+            QLayoutItem *item = child->itemAt(i);
+            if (item->widget() && typeid(*item) != typeid(QWidgetItemV2)) {
+                return false;
+            }
+        }
+
+        // Items are taken from the end, which keeps their order when they
+        // are pushed to the front of a reversed wrapper. Otherwise they are
+        // collected first and then appended in their original order.
+        QVector<Item> items;
+        items.reserve(child->count());
+        while (child->count() > 0) {
+            const int index = child->count() - 1;
+            const int stretch = child->stretch(index);
+            QLayoutItem *item = child->takeAt(index);
+            if (QWidget *widget = item->widget()) {
+                items.append(Item::fromWidget(widget, stretch, item->alignment()));
+                delete item;
+            } else if (QLayout *nested = item->layout()) {
+                items.append(Item::fromLayout(nested, stretch));
+            } else {
+                items.append(Item::fromLayoutItem(item, stretch));
+            }
+        }
+        if (m_reversed) {
+            for (const Item &item : qAsConst(items)) {
+                add(item);
+            }
+        } else {
+            for (auto it = items.crbegin(); it != items.crend(); ++it) {
+                add(*it);
+            }
+        }
+
+        delete child;
+        ++s_flattenedLayoutCount;
+        return true;
+    }
+
+    /**
+     * @brief Creates the box layout for VBox and HBox using the default
+     * engine.
+     */
+    static QBoxLayout *createLayout(QBoxLayout::Direction direction, QWidget *parent)
+    {
+        if (s_defaultEngine == Engine::Caching) {
+            return LayoutWraper::createLayout<LinearLayout>(parent, direction);
+        }
+        if (direction == QBoxLayout::TopToBottom) {
+            return LayoutWraper::createLayout<QVBoxLayout>(parent);
+        }
+        return LayoutWraper::createLayout<QHBoxLayout>(parent);
+    }
+
+    /**
+     * @brief Creates or commits and drops the pending children, so that the
+     * wrapper is batched exactly when batched mode was set or the wrapper is
+     * reversed.
+     */
+    void updateBatch()
+    {
+        const bool batched = m_batched || m_reversed;
+        if (batched && !m_batch) {
+            m_batch = std::make_shared<Batch>(p);
+        } else if (!batched && m_batch) {
+            commit();
+            m_batch.reset();
+        }
+    }
+
+    int placement() const
+    {
+        // 0 .. insert at the first position
+        // -1 .. insert at the last position
+        return m_reversed ? 0 : -1;
+    }
+
+    bool m_reversed = false;
+    bool m_batched = false;
+    std::shared_ptr<Batch> m_batch;
+
+    inline static Engine s_defaultEngine = Engine::Qt;
+    inline static bool s_flattening = false;
+    inline static int s_flattenedLayoutCount = 0;
+};
+
+/**
+ * @brief Layout wrapper for QVBoxLayout.
+ */
+class VBox : public Box
+{
+public:
+    explicit VBox(QWidget *parent,
+                  const Margins &margins = Margins(0),
+                  Spacing spacing = Spacing(-1))
+        : Box(createLayout(QBoxLayout::TopToBottom, parent), margins, spacing)
+    {}
+
+    explicit VBox(const Margins &margins, Spacing spacing = Spacing(-1))
+        : VBox(nullptr, margins, spacing)
+    {}
+
+    explicit VBox(Spacing spacing = Spacing(-1))
+        : VBox(nullptr, Margins(0), spacing)
+    {}
+};
+
+/**
+ * @brief Layout wrapper for QHBoxLayout.
+ */
+class HBox : public Box
+{
+public:
+    explicit HBox(QWidget *parent,
+                  const Margins &margins = Margins(0),
+                  Spacing spacing = Spacing(-1))
+        : Box(createLayout(QBoxLayout::LeftToRight, parent), margins, spacing)
+    {}
+
+    explicit HBox(const Margins &margins, Spacing spacing = Spacing(-1))
+        : HBox(nullptr, margins, spacing)
+    {}
+
+    explicit HBox(Spacing spacing = Spacing(-1))
+        : HBox(nullptr, Margins(0), spacing)
+    {}
+};
+
+/**
+ * @brief Lightweight form label, which is a layout item drawing its text
+ * directly on the parent widget of the form, instead of a QLabel widget.
+ * Form creates these items in place of label texts when lightweight labels
+ * are enabled. The text is shared from a pool of interned strings, so
+ * repeated labels of many forms share one string. The pool counts the items
+ * using each string and drops the string with its last item.
+ *
+ * The label is drawn with the font, palette and enabled state of the parent
+ * widget after the widget painted itself, so that widgets painting their own
+ * background or frame do not cover the labels, aligned according to
+ * QFormLayout::labelAlignment(). Mnemonics are
+ * underlined but have no shortcut and the label has no buddy. Use
+ * Form::label() to replace it with a real QLabel when needed.
+ */
+class FormLabelItem final : public QLayoutItem
+{
+public:
+    FormLabelItem(QFormLayout *form, const QString &text)
+        : m_form(form)
+        , m_text(intern(text))
+    {}
+
+    ~FormLabelItem() override
+    {
+        if (m_painter) {
+            m_painter->remove(this);
+        }
+        release(m_text);
+    }
+
+    const QString &text() const { return m_text; }
+
+    /**
+     * @brief Returns the number of distinct label texts in the pool.
+     */
+    static int internedCount() { return s_pool.size(); }
+
+    QSize sizeHint() const override
+    {
+        if (!m_sizeHint.isValid()) {
+            QWidget *widget = m_form->parentWidget();
+            const QFontMetrics metrics = widget ? widget->fontMetrics()
+                                                : QFontMetrics(QApplication::font());
+            m_sizeHint = metrics.size(Qt::TextShowMnemonic, m_text);
+        }
+        return m_sizeHint;
+    }
+
+    QSize minimumSize() const override { return sizeHint(); }
+
+    QSize maximumSize() const override { return QSize(QWIDGETSIZE_MAX, QWIDGETSIZE_MAX); }
+
+    Qt::Orientations expandingDirections() const override { return {}; }
+
+    bool isEmpty() const override { return false; }
+
+    void invalidate() override { m_sizeHint = QSize(); }
+
+    QRect geometry() const override { return m_geometry; }
+
+    void setGeometry(const QRect &rect) override
+    {
+        QWidget *widget = m_form->parentWidget();
+        if (!widget || rect == m_geometry) {
+            return;
+        }
+        if (!m_painter || m_painter->parent() != widget) {
+            if (m_painter) {
+                m_painter->remove(this);
+            }
+            m_painter = Painter::of(widget);
+            m_painter->add(this);
+        }
+        widget->update(m_geometry.united(rect));
+        m_geometry = rect;
+    }
+
+private:
+    /**
+     * @brief Paints all label items of one widget, as its event filter. It
+     * is a child of the widget, created by the first label item laid out
+     * on the widget.
+     */
+    class Painter final : public QObject
+    {
+    public:
+        static Painter *of(QWidget *widget)
+        {
+            auto painter = widget->property(PropertyName).value<QObject *>();
+            if (!painter) {
+                painter = new Painter(widget);
+                widget->setProperty(PropertyName, QVariant::fromValue(painter));
+            }
+            return static_cast<Painter *>(painter);
+        }
+
+        void add(FormLabelItem *item) { m_items.insert(item); }
+
+        void remove(FormLabelItem *item) { m_items.remove(item); }
+
+        bool eventFilter(QObject *watched, QEvent *event) override
+        {
+            auto widget = static_cast<QWidget *>(watched);
+            if (event->type() == QEvent::Paint) {
+                // Lets the widget paint itself first and paints the labels
+                // over it. QObject::event() is public and does not run the
+                // event filters again.
+                watched->event(event);
+                const QRect exposed = static_cast<QPaintEvent *>(event)->rect();
+                QPainter painter(widget);
+                for (FormLabelItem *item : qAsConst(m_items)) {
+                    if (item->m_geometry.intersects(exposed)) {
+                        item->paint(&painter, widget);
+                    }
+                }
+                return true;
+            } else if (event->type() == QEvent::FontChange) {
+                QSet<QFormLayout *> forms;
+                for (FormLabelItem *item : qAsConst(m_items)) {
+                    item->invalidate();
+                    forms.insert(item->m_form);
+                }
+                for (QFormLayout *form : qAsConst(forms)) {
+                    form->invalidate();
+                }
+            }
+            return false;
+        }
+
+    private:
+        static constexpr const char *PropertyName = "_qtutils_formLabelPainter";
+
+        explicit Painter(QWidget *widget)
+            : QObject(widget)
+        {
+            widget->installEventFilter(this);
+        }
+
+        QSet<FormLabelItem *> m_items;
+    };
+
+    /**
+     * @brief Returns a string equal to text, sharing its data with all
+     * other items using an equal text.
+     */
+    static QString intern(const QString &text)
+    {
+        auto it = s_pool.find(text);
+        if (it == s_pool.end()) {
+            it = s_pool.insert(text, { text, 0 });
+        }
+        ++it->references;
+        return it->text;
+    }
+
+    static void release(const QString &text)
+    {
+        auto it = s_pool.find(text);
+        if (it != s_pool.end() && --it->references == 0) {
+            s_pool.erase(it);
+        }
+    }
+
+    void paint(QPainter *painter, QWidget *widget) const
+    {
+        Qt::Alignment alignment = m_form->labelAlignment();
+        if (!(alignment & Qt::AlignVertical_Mask)) {
+            alignment |= Qt::AlignVCenter;
+        }
+        widget->style()->drawItemText(painter, m_geometry, int(alignment | Qt::TextShowMnemonic),
+                                      widget->palette(), widget->isEnabled(), m_text,
+                                      QPalette::WindowText);
+    }
+
+    QFormLayout *m_form;
+    QString m_text;
+    QRect m_geometry;
+    mutable QSize m_sizeHint;
+    QPointer<Painter> m_painter;
+
+    struct Interned
+    {
+        QString text;
+        int references;
+    };
+
+    inline static QHash<QString, Interned> s_pool;
+};
+
+/**
+ * @brief Wrapper of items to be added in a single row to a Form layout wrapper.
+ */
+class Row final
+{
+public:
+    Row(QWidget *label, QWidget *widget)
+        : m_label(label)
+        , m_widget(widget)
+    {}
+
+    Row(const QString &labelText, QWidget *widget)
+        : m_labelText(labelText)
+        , m_widget(widget)
+    {}
+
+    Row(QWidget *label, QLayout *layout)
+        : m_label(label)
+        , m_layout(layout)
+    {}
+
+    Row(const QString &labelText, QLayout *layout)
         : m_labelText(labelText)
         , m_layout(layout)
     {
@@ -466,7 +1207,7 @@ public:
     explicit Form(QWidget *parent,
                   const Margins &margins = Margins(0),
                   Spacing spacing = Spacing(-1))
-        : LayoutWraper<QFormLayout>(new QFormLayout(parent), margins, spacing)
+        : LayoutWraper<QFormLayout>(createLayout<QFormLayout>(parent), margins, spacing)
     {}
 
     explicit Form(const Margins &margins, Spacing spacing = Spacing(-1))
@@ -477,8 +1218,67 @@ public:
         : Form(nullptr, Margins(0), spacing)
     {}
 
+    /**
+     * @brief Enables lightweight labels. Rows added with label text then get
+     * a FormLabelItem instead of a QLabel widget. Disabled by default.
+     */
+    Form &setLightweightLabels(bool value)
+    {
+        m_lightweightLabels = value;
+        return *this;
+    }
+
+    bool hasLightweightLabels() const { return m_lightweightLabels; }
+
+    /**
+     * @brief Makes the labels of rows added from now on members of a
+     * SizeGroup from sizegroup.h, which aligns the field column with other
+     * forms of the group. Labels of such rows are always QLabel widgets.
+     */
+    template<typename SizeGroup_T>
+    Form &setLabelGroup(const SizeGroup_T &group)
+    {
+        m_labelGroup = [group](QFormLayout *form, QWidget *label) { group.adopt(form, label); };
+        return *this;
+    }
+
+    /**
+     * @brief Returns the label widget of a row. A lightweight label is
+     * replaced with a QLabel first. Returns nullptr if the row has no label
+     * or the label is not a QLabel.
+     */
+    QLabel *label(int row) const
+    {
+        QLayoutItem *item = p->itemAt(row, QFormLayout::LabelRole);
+        auto lightweight = dynamic_cast<FormLabelItem *>(item);
+        if (!lightweight) {
+            return item ? qobject_cast<QLabel *>(item->widget()) : nullptr;
+        }
+
+        auto label = new QLabel(lightweight->text());
+        p->removeItem(lightweight);
+        delete lightweight;
+        p->setWidget(row, QFormLayout::LabelRole, label);
+        if (QLayoutItem *field = p->itemAt(row, QFormLayout::FieldRole)) {
+            label->setBuddy(field->widget());
+        }
+        return label;
+    }
+
     Form &operator<<(const Row &row)
     {
+        const int index = p->rowCount();
+        if (m_lightweightLabels && !m_labelGroup && !row.label() && !row.labelText().isNull()
+            && (row.widget() || row.layout())) {
+            p->setItem(index, QFormLayout::LabelRole, new FormLabelItem(p, row.labelText()));
+            if (row.widget()) {
+                p->setWidget(index, QFormLayout::FieldRole, row.widget());
+            } else {
+                p->setLayout(index, QFormLayout::FieldRole, row.layout());
+            }
+            return *this;
+        }
+
         if (row.widget()) {
             if (row.label()) {
                 p->addRow(row.label(), row.widget());
@@ -496,6 +1296,538 @@ public:
                 p->addRow(row.layout());
             }
         }
+
+        if (m_labelGroup) {
+            QLayoutItem *label = p->itemAt(index, QFormLayout::LabelRole);
+            if (label && label->widget()) {
+                m_labelGroup(p, label->widget());
+            }
+        }
+        return *this;
+    }
+
+private:
+    bool m_lightweightLabels = false;
+    std::function<void(QFormLayout *, QWidget *)> m_labelGroup;
+};
+
+/**
+ * @brief Places a child widget or layout into an explicit cell of a Grid
+ * layout wrapper, optionally spanning several rows and columns.
+ */
+class Cell final
+{
+public:
+    Cell(QWidget *widget,
+         int row,
+         int column,
+         int rowSpan = 1,
+         int columnSpan = 1,
+         Qt::Alignment alignment = {})
+        : m_widget(widget)
+        , m_row(row)
+        , m_column(column)
+        , m_rowSpan(rowSpan)
+        , m_columnSpan(columnSpan)
+        , m_alignment(alignment)
+    {}
+
+    Cell(QLayout *layout,
+         int row,
+         int column,
+         int rowSpan = 1,
+         int columnSpan = 1,
+         Qt::Alignment alignment = {})
+        : m_layout(layout)
+        , m_row(row)
+        , m_column(column)
+        , m_rowSpan(rowSpan)
+        , m_columnSpan(columnSpan)
+        , m_alignment(alignment)
+    {}
+
+    QWidget *widget() const { return m_widget; }
+
+    QLayout *layout() const { return m_layout; }
+
+    int row() const { return m_row; }
+
+    int column() const { return m_column; }
+
+    int rowSpan() const { return m_rowSpan; }
+
+    int columnSpan() const { return m_columnSpan; }
+
+    Qt::Alignment alignment() const { return m_alignment; }
+
+private:
+    QWidget *m_widget = nullptr;
+    QLayout *m_layout = nullptr;
+    int m_row;
+    int m_column;
+    int m_rowSpan;
+    int m_columnSpan;
+    Qt::Alignment m_alignment;
+};
+
+/**
+ * @brief Places a child widget or layout spanning several rows and columns
+ * into the next free cell of a Grid layout wrapper.
+ */
+class Span final
+{
+public:
+    Span(QWidget *widget, int rowSpan, int columnSpan, Qt::Alignment alignment = {})
+        : m_widget(widget)
+        , m_rowSpan(rowSpan)
+        , m_columnSpan(columnSpan)
+        , m_alignment(alignment)
+    {}
+
+    Span(QLayout *layout, int rowSpan, int columnSpan, Qt::Alignment alignment = {})
+        : m_layout(layout)
+        , m_rowSpan(rowSpan)
+        , m_columnSpan(columnSpan)
+        , m_alignment(alignment)
+    {}
+
+    QWidget *widget() const { return m_widget; }
+
+    QLayout *layout() const { return m_layout; }
+
+    int rowSpan() const { return m_rowSpan; }
+
+    int columnSpan() const { return m_columnSpan; }
+
+    Qt::Alignment alignment() const { return m_alignment; }
+
+private:
+    QWidget *m_widget = nullptr;
+    QLayout *m_layout = nullptr;
+    int m_rowSpan;
+    int m_columnSpan;
+    Qt::Alignment m_alignment;
+};
+
+/**
+ * @brief Layout wrapper for QGridLayout. Children added with Cell are placed
+ * to explicit coordinates, other children (widgets, layouts, Aligned and
+ * Span) flow row by row into the next free cell of a grid with the given
+ * number of columns. A nullptr child still occupies its cell so that the
+ * following children stay in their columns.
+ *
+ * Children are not inserted one by one. The wrapper collects them and when
+ * it is converted to the layout pointer, when commit() is called or when the
+ * last copy of the wrapper is destroyed, it computes the coordinates of all
+ * cells first and then inserts them in one pass, with the layout disabled and
+ * updates of the parent widget suppressed.
+ *
+ * Example of a simple data entry grid:
+ *
+ * Grid(dialog, Margins()).setColumns(2)
+ *     << nameLabel << nameEdit
+ *     << mailLabel << mailEdit
+ *     << Span(notesEdit, 1, 2);
+ */
+class Grid : public LayoutWraper<QGridLayout>
+{
+public:
+    explicit Grid(QWidget *parent,
+                  const Margins &margins = Margins(0),
+                  Spacing spacing = Spacing(-1))
+        : LayoutWraper<QGridLayout>(createLayout<QGridLayout>(parent), margins, spacing)
+        , m_batch(std::make_shared<Batch>(p))
+    {}
+
+    explicit Grid(const Margins &margins, Spacing spacing = Spacing(-1))
+        : Grid(nullptr, margins, spacing)
+    {}
+
+    explicit Grid(Spacing spacing = Spacing(-1))
+        : Grid(nullptr, Margins(0), spacing)
+    {}
+
+    /**
+     * @brief Implicit conversion to the wrapped layout. Pending children are
+     * committed before the layout is handed out.
+     */
+    operator QGridLayout *() const
+    {
+        commit();
+        return p;
+    }
+
+    /**
+     * @brief Dereference operator can be used to access methods of the wrapped
+     * layout. Pending children are committed first.
+     */
+    QGridLayout *operator->() const
+    {
+        commit();
+        return p;
+    }
+
+    /**
+     * @brief Sets the number of columns used for placing children which do
+     * not have explicit coordinates. Default is 1.
+     */
+    Grid &setColumns(int columns)
+    {
+        m_batch->setColumns(columns);
+        return *this;
+    }
+
+    int columns() const { return m_batch->columns(); }
+
+    /**
+     * @brief Adds a child widget to the next free cell.
+     */
+    Grid &operator<<(QWidget *widget)
+    {
+        m_batch->append({ widget, nullptr, -1, -1, 1, 1, {} });
         return *this;
     }
+
+    /**
+     * @brief Adds a child layout to the next free cell. The child layout can
+     * also be a result of implicit conversion from layout wrapper.
+     */
+    Grid &operator<<(QLayout *layout)
+    {
+        m_batch->append({ nullptr, layout, -1, -1, 1, 1, {} });
+        return *this;
+    }
+
+    /**
+     * @brief Adds an aligned widget to the next free cell.
+     */
+    Grid &operator<<(const Aligned &aligned)
+    {
+        m_batch->append({ aligned.widget(), nullptr, -1, -1, 1, 1, aligned.alignment() });
+        return *this;
+    }
+
+    /**
+     * @brief Adds a spanning widget or layout to the next free cell where it
+     * fits.
+     */
+    Grid &operator<<(const Span &span)
+    {
+        m_batch->append({ span.widget(),
+                          span.layout(),
+                          -1,
+                          -1,
+                          span.rowSpan(),
+                          span.columnSpan(),
+                          span.alignment() });
+        return *this;
+    }
+
+    /**
+     * @brief Adds a widget or layout to explicit coordinates.
+     */
+    Grid &operator<<(const Cell &cell)
+    {
+        m_batch->append({ cell.widget(),
+                          cell.layout(),
+                          cell.row(),
+                          cell.column(),
+                          cell.rowSpan(),
+                          cell.columnSpan(),
+                          cell.alignment() });
+        return *this;
+    }
+
+    /**
+     * @brief Computes coordinates of all pending children and inserts them
+     * into the wrapped layout.
+     */
+    void commit() const { m_batch->commit(); }
+
+protected:
+    /**
+     * @brief Descriptor of a single cell. Negative row means that the cell
+     * is placed to the next free position.
+     */
+    struct Item
+    {
+        QWidget *widget;
+        QLayout *layout;
+        int row;
+        int column;
+        int rowSpan;
+        int columnSpan;
+        Qt::Alignment alignment;
+    };
+
+    /**
+     * @brief Pending children of the wrapper. It is shared by all copies of
+     * the wrapper and commits the remaining children when destroyed, unless
+     * the layout was deleted in the meantime.
+     */
+    class Batch final
+    {
+    public:
+        explicit Batch(QGridLayout *layout)
+            : m_layout(layout)
+        {}
+
+        ~Batch() { commit(); }
+
+        void setColumns(int columns)
+        {
+            // The occupied cells are stored row by row, so the number of
+            // columns can be changed only before anything is placed.
+            Q_ASSERT(m_occupied.isEmpty());
+            m_columns = qMax(1, columns);
+        }
+
+        int columns() const { return m_columns; }
+
+        void append(const Item &item) { m_items.append(item); }
+
+        void commit()
+        {
+            if (m_items.isEmpty()) {
+                return;
+            }
+            if (!m_layout) {
+                m_items.clear();
+                return;
+            }
+
+            place();
+
+            QWidget *parent = m_layout->parentWidget();
+            const bool updates = parent && parent->updatesEnabled();
+            const bool enabled = m_layout->isEnabled();
+            if (updates) {
+                parent->setUpdatesEnabled(false);
+            }
+            m_layout->setEnabled(false);
+
+            for (const Item &item : qAsConst(m_items)) {
+                if (item.widget) {
+                    m_layout->addWidget(item.widget,
+                                        item.row,
+                                        item.column,
+                                        item.rowSpan,
+                                        item.columnSpan,
+                                        item.alignment);
+                } else if (item.layout) {
+                    m_layout->addLayout(item.layout,
+                                        item.row,
+                                        item.column,
+                                        item.rowSpan,
+                                        item.columnSpan,
+                                        item.alignment);
+                }
+            }
+            m_items.clear();
+
+            m_layout->setEnabled(enabled);
+            if (updates) {
+                parent->setUpdatesEnabled(true);
+            }
+            m_layout->invalidate();
+        }
+
+    private:
+        // Computes coordinates of the items without explicit ones. Cells
+        // occupied by explicit items are reserved first, then the remaining
+        // items are placed row by row to the first position where they fit.
+        void place()
+        {
+            QVector<bool> &occupied = m_occupied;
+            auto isOccupied = [&](int row, int column) {
+                const int index = row * m_columns + column;
+                return index < occupied.size() && occupied.at(index);
+            };
+            auto occupy = [&](const Item &item) {
+                const int lastRow = item.row + qMax(1, item.rowSpan) - 1;
+                const int lastColumn = qMin(m_columns, item.column + qMax(1, item.columnSpan)) - 1;
+                const int size = (lastRow + 1) * m_columns;
+                if (occupied.size() < size) {
+                    occupied.resize(size);
+                }
+                for (int row = item.row; row <= lastRow; ++row) {
+                    for (int column = item.column; column <= lastColumn; ++column) {
+                        occupied[row * m_columns + column] = true;
+                    }
+                }
+            };
+            auto fits = [&](int row, int column, const Item &item) {
+                const int columnSpan = qMin(m_columns, qMax(1, item.columnSpan));
+                if (column + columnSpan > m_columns) {
+                    return false;
+                }
+                for (int r = row; r < row + qMax(1, item.rowSpan); ++r) {
+                    for (int c = column; c < column + columnSpan; ++c) {
+                        if (isOccupied(r, c)) {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+            };
+
+            for (const Item &item : qAsConst(m_items)) {
+                if (item.row >= 0) {
+                    occupy(item);
+                }
+            }
+
+            for (Item &item : m_items) {
+                if (item.row >= 0) {
+                    continue;
+                }
+                while (!fits(m_nextRow, m_nextColumn, item)) {
+                    if (++m_nextColumn >= m_columns) {
+                        m_nextColumn = 0;
+                        ++m_nextRow;
+                    }
+                }
+                item.row = m_nextRow;
+                item.column = m_nextColumn;
+                item.columnSpan = qMin(m_columns, qMax(1, item.columnSpan));
+                occupy(item);
+            }
+        }
+
+        QPointer<QGridLayout> m_layout;
+        QVector<Item> m_items;
+        QVector<bool> m_occupied;
+        int m_columns = 1;
+        int m_nextRow = 0;
+        int m_nextColumn = 0;
+    };
+
+    std::shared_ptr<Batch> m_batch;
+};
+
+/**
+ * @brief Wrapper of QStackedLayout. Pages are added in order, use Lazy pages
+ * to construct them the first time they become current.
+ */
+class Stack : public LayoutWraper<QStackedLayout>
+{
+public:
+    explicit Stack(QWidget *parent, const Margins &margins = Margins(0))
+        : LayoutWraper<QStackedLayout>(createLayout<QStackedLayout>(parent), margins, Spacing(-1))
+    {}
+
+    explicit Stack(const Margins &margins = Margins(0))
+        : Stack(nullptr, margins)
+    {}
+
+    /**
+     * @brief Enables prefetching of the page following the current page. It
+     * is materialized when the event loop becomes idle after the current
+     * page changes, if it is a Lazy page. Disabled by default.
+     */
+    Stack &setPrefetching(bool prefetching)
+    {
+        if (prefetching && !m_prefetching) {
+            QStackedLayout *layout = p;
+            QObject::connect(layout, &QStackedLayout::currentChanged, layout, [layout](int index) {
+                LazyWidget::materializeLater(layout->widget(index + 1));
+            });
+            LazyWidget::materializeLater(layout->widget(layout->currentIndex() + 1));
+        }
+        m_prefetching = m_prefetching || prefetching;
+        return *this;
+    }
+
+    /**
+     * @brief Adds a page. If the page is null, it will be ignored.
+     */
+    Stack &operator<<(QWidget *page)
+    {
+        if (page) {
+            p->addWidget(page);
+            if (m_prefetching && p->count() == p->currentIndex() + 2) {
+                LazyWidget::materializeLater(page);
+            }
+        }
+        return *this;
+    }
+
+private:
+    bool m_prefetching = false;
+};
+
+/**
+ * @brief Page of Tabs with its tab title.
+ */
+class Tab final
+{
+public:
+    Tab(const QString &title, QWidget *page)
+        : m_title(title)
+        , m_page(page)
+    {}
+
+    const QString &title() const { return m_title; }
+
+    QWidget *page() const { return m_page; }
+
+private:
+    QString m_title;
+    QWidget *m_page;
+};
+
+/**
+ * @brief Wrapper of QTabWidget, which can be added to layout wrappers like
+ * any widget. Use Lazy pages to construct them the first time their tab
+ * becomes current.
+ */
+class Tabs final
+{
+public:
+    explicit Tabs(QWidget *parent = nullptr)
+        : p(new QTabWidget(parent))
+    {}
+
+    /**
+     * @brief Implicit conversion to the wrapped tab widget.
+     */
+    operator QTabWidget *() const { return p; }
+
+    QTabWidget *operator->() const { return p; }
+
+    /**
+     * @brief Enables prefetching of the page following the current page. It
+     * is materialized when the event loop becomes idle after the current
+     * tab changes, if it is a Lazy page. Disabled by default.
+     */
+    Tabs &setPrefetching(bool prefetching)
+    {
+        if (prefetching && !m_prefetching) {
+            QTabWidget *tabs = p;
+            QObject::connect(tabs, &QTabWidget::currentChanged, tabs, [tabs](int index) {
+                LazyWidget::materializeLater(tabs->widget(index + 1));
+            });
+            LazyWidget::materializeLater(tabs->widget(tabs->currentIndex() + 1));
+        }
+        m_prefetching = m_prefetching || prefetching;
+        return *this;
+    }
+
+    /**
+     * @brief Adds a tab. If the page is null, it will be ignored.
+     */
+    Tabs &operator<<(const Tab &tab)
+    {
+        if (tab.page()) {
+            p->addTab(tab.page(), tab.title());
+            if (m_prefetching && p->count() == p->currentIndex() + 2) {
+                LazyWidget::materializeLater(tab.page());
+            }
+        }
+        return *this;
+    }
+
+private:
+    QTabWidget *p;
+    bool m_prefetching = false;
 };
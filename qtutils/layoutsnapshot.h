@@ -0,0 +1,506 @@
+#pragma once
+
+#include <QByteArray>
+#include <QLabel>
+#include <QPointer>
+#include <QSpacerItem>
+
+#include <cstring>
+#include <functional>
+
+#include "layouts.h"
+
+//
+// Compact binary snapshot of a layout hierarchy built with VBox, HBox, Form,
+// Row, Stretch, Stretched, Spacing and Aligned. The snapshot stores the
+// structure, margins, spacing, stretch factors and alignments of the layouts.
+// Widgets are stored as integer IDs given by the caller, except for form
+// labels without an ID, which are stored as their text.
+//
+// A snapshot is a sequence of 32-bit words in native byte order, so it can be
+// stored to a file, memory-mapped and replayed directly from the mapped
+// memory. Replaying does not parse anything and allocates only the layouts,
+// the widgets created by the factory and the label texts:
+//
+// // when building the snapshot, e.g. in a tool generating resources
+// const QByteArray snapshot = LayoutSnapshot::record(dialog->layout(), [&](QWidget *widget) {
+//     return ids.value(widget, -1);
+// });
+//
+// // when opening the dialog
+// QFile file(":/dialogs/settings.qls");
+// file.open(QIODevice::ReadOnly);
+// LayoutSnapshot::replay(file.map(0, file.size()), file.size(), [&](int id) {
+//     return createWidget(id);
+// }, dialog);
+//
+// Widgets without an ID (other than form labels) and layouts other than box
+// and form layouts are left out of the snapshot. Replay rejects snapshots
+// with layouts nested deeper than LayoutSnapshot::MaxDepth, so that crafted
+// data cannot overflow the stack.
+//
+
+/**
+ * @brief Records layout hierarchies to binary snapshots and replays them into
+ * live layouts.
+ */
+class LayoutSnapshot final
+{
+public:
+    /**
+     * @brief Returns the ID of a widget or -1 if the widget is not to be
+     * stored in the snapshot.
+     */
+    using WidgetId = std::function<int(QWidget *)>;
+
+    /**
+     * @brief Creates a widget for an ID stored in the snapshot. Returning
+     * nullptr leaves the widget out of the replayed layout.
+     */
+    using WidgetFactory = std::function<QWidget *(int)>;
+
+    /**
+     * @brief Maximum nesting depth of layouts accepted by replay(), the top
+     * level layout having depth 1.
+     */
+    static constexpr int MaxDepth = 64;
+
+    /**
+     * @brief Records the layout hierarchy into a binary snapshot. Returns an
+     * empty array if the layout is neither a box nor a form layout.
+     */
+    static QByteArray record(QLayout *layout, const WidgetId &widgetId)
+    {
+        QVector<qint32> words;
+        words << Magic;
+        if (!recordLayout(words, layout, 0, widgetId)) {
+            return QByteArray();
+        }
+        return QByteArray(reinterpret_cast<const char *>(words.constData()),
+                          words.size() * int(sizeof(qint32)));
+    }
+
+    /**
+     * @brief Creates the layout hierarchy stored in the snapshot and installs
+     * it to the parent widget (if any). The data must be aligned to 4 bytes,
+     * which holds for QByteArray data and for memory-mapped files. Returns
+     * nullptr if the data is not a valid snapshot, in which case the widgets
+     * already returned by the factory are deleted.
+     */
+    static QLayout *replay(const uchar *data,
+                           qint64 size,
+                           const WidgetFactory &createWidget,
+                           QWidget *parent = nullptr)
+    {
+        Reader reader(reinterpret_cast<const qint32 *>(data), size / qint64(sizeof(qint32)));
+        if (!data || reader.next() != Magic) {
+            return nullptr;
+        }
+
+        // The widgets are not owned by anything until the layout is installed,
+        // so they are deleted together with the layout if the data turns out
+        // to be invalid halfway through.
+        QVector<QPointer<QWidget>> created;
+        const WidgetFactory createTracked = [&](int id) {
+            QWidget *widget = createWidget(id);
+            if (widget) {
+                created << widget;
+            }
+            return widget;
+        };
+
+        int stretch = 0;
+        QLayout *layout = replayLayout(reader, reader.next(), stretch, createTracked, 1);
+        if (!reader.isValid()) {
+            if (layout) {
+                collectWidgets(layout, created);
+                delete layout;
+            }
+            for (QWidget *widget : qAsConst(created)) {
+                delete widget;
+            }
+            return nullptr;
+        }
+        if (parent && layout) {
+            parent->setLayout(layout);
+        }
+        return layout;
+    }
+
+    static QLayout *replay(const QByteArray &snapshot,
+                           const WidgetFactory &createWidget,
+                           QWidget *parent = nullptr)
+    {
+        return replay(reinterpret_cast<const uchar *>(snapshot.constData()),
+                      snapshot.size(),
+                      createWidget,
+                      parent);
+    }
+
+private:
+    // "QLS1" with the first letter in the lowest byte, which also detects
+    // snapshots stored with different byte order.
+    static constexpr qint32 Magic = 0x31534c51;
+
+    enum Record : qint32 {
+        // op, direction, left, top, right, bottom, spacing, stretch, count, items...
+        BoxRecord = 1,
+        // op, left, top, right, bottom, horizontal spacing, vertical spacing, stretch, count, rows...
+        FormRecord,
+        // op, label record, field record
+        RowRecord,
+        // op, id, stretch, alignment
+        WidgetRecord,
+        // op, length, UTF-16 data padded to 32 bits
+        TextRecord,
+        // op, stretch
+        StretchRecord,
+        // op, size
+        SpacingRecord,
+        // op
+        EmptyRecord
+    };
+
+    class Reader final
+    {
+    public:
+        Reader(const qint32 *data, qint64 size)
+            : m_data(data)
+            , m_end(data ? data + size : nullptr)
+        {}
+
+        qint32 next()
+        {
+            if (m_data == m_end) {
+                m_valid = false;
+                return 0;
+            }
+            return *m_data++;
+        }
+
+        /**
+         * @brief Skips the UTF-16 data of a text record and returns a
+         * pointer to it.
+         */
+        const QChar *text(int length)
+        {
+            const qint64 words = (qint64(length) + 1) / 2;
+            if (length < 0 || words > m_end - m_data) {
+                m_valid = false;
+                return nullptr;
+            }
+            auto text = reinterpret_cast<const QChar *>(m_data);
+            m_data += words;
+            return text;
+        }
+
+        void invalidate() { m_valid = false; }
+
+        bool isValid() const { return m_valid; }
+
+    private:
+        const qint32 *m_data;
+        const qint32 *m_end;
+        bool m_valid = true;
+    };
+
+    static bool recordLayout(QVector<qint32> &words, QLayout *layout, int stretch, const WidgetId &widgetId)
+    {
+        const QMargins margins = layout->contentsMargins();
+
+        if (auto box = qobject_cast<QBoxLayout *>(layout)) {
+            const bool horizontal = box->direction() == QBoxLayout::LeftToRight
+                                    || box->direction() == QBoxLayout::RightToLeft;
+            const int spacing = explicitSpacing(box,
+                                                box->spacing(),
+                                                horizontal ? QStyle::PM_LayoutHorizontalSpacing
+                                                           : QStyle::PM_LayoutVerticalSpacing);
+            words << BoxRecord << box->direction() << margins.left() << margins.top()
+                  << margins.right() << margins.bottom() << spacing << stretch;
+            const int countIndex = words.size();
+            words << 0;
+            for (int i = 0; i < box->count(); ++i) {
+                QLayoutItem *item = box->itemAt(i);
+                const int itemStretch = box->stretch(i);
+                if (QWidget *widget = item->widget()) {
+                    const int id = widgetId(widget);
+                    if (id < 0) {
+                        continue;
+                    }
+                    words << WidgetRecord << id << itemStretch << int(item->alignment());
+                } else if (QLayout *child = item->layout()) {
+                    if (!recordLayout(words, child, itemStretch, widgetId)) {
+                        continue;
+                    }
+                } else if (QSpacerItem *spacer = item->spacerItem()) {
+                    const Qt::Orientations expanding = spacer->expandingDirections();
+                    if (expanding & (horizontal ? Qt::Horizontal : Qt::Vertical)) {
+                        words << StretchRecord << itemStretch;
+                    } else {
+                        const QSize size = spacer->sizeHint();
+                        words << SpacingRecord << (horizontal ? size.width() : size.height());
+                    }
+                } else {
+                    continue;
+                }
+                ++words[countIndex];
+            }
+            return true;
+        }
+
+        if (auto form = qobject_cast<QFormLayout *>(layout)) {
+            words << FormRecord << margins.left() << margins.top() << margins.right()
+                  << margins.bottom()
+                  << explicitSpacing(form, form->horizontalSpacing(), QStyle::PM_LayoutHorizontalSpacing)
+                  << explicitSpacing(form, form->verticalSpacing(), QStyle::PM_LayoutVerticalSpacing)
+                  << stretch;
+            const int countIndex = words.size();
+            words << 0;
+            for (int row = 0; row < form->rowCount(); ++row) {
+                const int rowIndex = words.size();
+                words << RowRecord;
+                bool hasField = false;
+                if (QLayoutItem *spanning = form->itemAt(row, QFormLayout::SpanningRole)) {
+                    words << EmptyRecord;
+                    hasField = recordFormItem(words, spanning, widgetId);
+                } else {
+                    QLayoutItem *label = form->itemAt(row, QFormLayout::LabelRole);
+                    if (!label || !recordFormItem(words, label, widgetId)) {
+                        words << EmptyRecord;
+                    }
+                    QLayoutItem *field = form->itemAt(row, QFormLayout::FieldRole);
+                    hasField = field && recordFormItem(words, field, widgetId);
+                }
+                if (hasField) {
+                    ++words[countIndex];
+                } else {
+                    words.resize(rowIndex);
+                }
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Returns the spacing of a layout or -1 if it is the spacing the
+     * layout inherits when none is set, i.e. the spacing of the parent layout
+     * or the style metric of the parent widget. Qt only reports the effective
+     * spacing, so a spacing set explicitly to the inherited value is recorded
+     * as inherited too.
+     */
+    static int explicitSpacing(QLayout *layout, int spacing, QStyle::PixelMetric metric)
+    {
+        int inherited = -1;
+        if (auto parent = qobject_cast<QLayout *>(layout->parent())) {
+            inherited = parent->spacing();
+        } else if (QWidget *parent = layout->parentWidget()) {
+            inherited = parent->style()->pixelMetric(metric, nullptr, parent);
+        }
+        return spacing == inherited ? -1 : spacing;
+    }
+
+    static bool recordFormItem(QVector<qint32> &words, QLayoutItem *item, const WidgetId &widgetId)
+    {
+        if (QWidget *widget = item->widget()) {
+            const int id = widgetId(widget);
+            if (id >= 0) {
+                words << WidgetRecord << id << 0 << int(item->alignment());
+                return true;
+            }
+            auto label = qobject_cast<QLabel *>(widget);
+            if (!label) {
+                return false;
+            }
+            const QString text = label->text();
+            words << TextRecord << text.size();
+            const int textIndex = words.size();
+            words.resize(textIndex + (text.size() + 1) / 2);
+            memcpy(words.data() + textIndex, text.constData(), size_t(text.size()) * sizeof(QChar));
+            return true;
+        }
+        if (QLayout *child = item->layout()) {
+            return recordLayout(words, child, 0, widgetId);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Replays a box or form record at the given nesting depth. The
+     * stretch of the layout in its parent box is returned in the stretch
+     * argument.
+     */
+    static QLayout *replayLayout(Reader &reader,
+                                 qint32 record,
+                                 int &stretch,
+                                 const WidgetFactory &createWidget,
+                                 int depth)
+    {
+        if (depth > MaxDepth) {
+            reader.invalidate();
+            return nullptr;
+        }
+        if (record == BoxRecord) {
+            return replayBox(reader, stretch, createWidget, depth);
+        }
+        if (record == FormRecord) {
+            return replayForm(reader, stretch, createWidget, depth);
+        }
+        reader.invalidate();
+        return nullptr;
+    }
+
+    /**
+     * @brief Collects the widgets in the layout hierarchy, which also covers
+     * the labels created for label texts. The layout items refer to the
+     * widgets, so the widgets are deleted only after the layout.
+     */
+    static void collectWidgets(QLayout *layout, QVector<QPointer<QWidget>> &widgets)
+    {
+        for (int i = 0; i < layout->count(); ++i) {
+            QLayoutItem *item = layout->itemAt(i);
+            if (QLayout *child = item->layout()) {
+                collectWidgets(child, widgets);
+            } else if (QWidget *widget = item->widget()) {
+                widgets << widget;
+            }
+        }
+    }
+
+    static QBoxLayout *replayBox(Reader &reader,
+                                 int &stretch,
+                                 const WidgetFactory &createWidget,
+                                 int depth)
+    {
+        const qint32 direction = reader.next();
+        if (direction < QBoxLayout::LeftToRight || direction > QBoxLayout::BottomToTop) {
+            reader.invalidate();
+            return nullptr;
+        }
+        // The arguments of a constructor are evaluated in unspecified order.
+        const int left = reader.next();
+        const int top = reader.next();
+        const int right = reader.next();
+        const int bottom = reader.next();
+        const Margins margins(left, top, right, bottom);
+        const Spacing spacing(reader.next());
+        stretch = reader.next();
+        const int count = reader.next();
+
+        const bool horizontal = direction == QBoxLayout::LeftToRight
+                                || direction == QBoxLayout::RightToLeft;
+        Box box = horizontal ? Box(HBox(margins, spacing)) : Box(VBox(margins, spacing));
+        box->setDirection(QBoxLayout::Direction(direction));
+
+        for (int i = 0; i < count && reader.isValid(); ++i) {
+            const qint32 record = reader.next();
+            switch (record) {
+            case WidgetRecord: {
+                const int id = reader.next();
+                const int stretch = reader.next();
+                const auto alignment = Qt::Alignment(QFlag(reader.next()));
+                box << Aligned(createWidget(id), alignment, stretch);
+                break;
+            }
+            case BoxRecord:
+            case FormRecord: {
+                int childStretch = 0;
+                QLayout *child = replayLayout(reader, record, childStretch, createWidget,
+                                              depth + 1);
+                if (!child) {
+                    break;
+                }
+                if (childStretch != 0) {
+                    box << Stretched(child, childStretch);
+                } else {
+                    box << child;
+                }
+                break;
+            }
+            case StretchRecord:
+                box << Stretch(reader.next());
+                break;
+            case SpacingRecord:
+                box << Spacing(reader.next());
+                break;
+            default:
+                reader.invalidate();
+                break;
+            }
+        }
+        return box;
+    }
+
+    static QFormLayout *replayForm(Reader &reader,
+                                   int &stretch,
+                                   const WidgetFactory &createWidget,
+                                   int depth)
+    {
+        const int left = reader.next();
+        const int top = reader.next();
+        const int right = reader.next();
+        const int bottom = reader.next();
+        const Margins margins(left, top, right, bottom);
+        const int horizontalSpacing = reader.next();
+        const int verticalSpacing = reader.next();
+        stretch = reader.next();
+        const int count = reader.next();
+
+        Form form(margins);
+        form->setHorizontalSpacing(horizontalSpacing);
+        form->setVerticalSpacing(verticalSpacing);
+
+        for (int i = 0; i < count && reader.isValid(); ++i) {
+            if (reader.next() != RowRecord) {
+                reader.invalidate();
+                break;
+            }
+
+            QWidget *label = nullptr;
+            QString labelText;
+            switch (reader.next()) {
+            case WidgetRecord:
+                label = createWidget(reader.next());
+                reader.next(); // stretch
+                reader.next(); // alignment
+                break;
+            case TextRecord: {
+                const int length = reader.next();
+                if (const QChar *text = reader.text(length)) {
+                    labelText = QString(text, length);
+                }
+                break;
+            }
+            case EmptyRecord:
+                break;
+            default:
+                reader.invalidate();
+                break;
+            }
+
+            QWidget *widget = nullptr;
+            QLayout *layout = nullptr;
+            const qint32 record = reader.next();
+            if (record == WidgetRecord) {
+                widget = createWidget(reader.next());
+                reader.next(); // stretch
+                reader.next(); // alignment
+            } else {
+                int childStretch = 0;
+                layout = replayLayout(reader, record, childStretch, createWidget, depth + 1);
+            }
+
+            if (!widget && !layout) {
+                delete label;
+            } else if (label) {
+                form << (widget ? Row(label, widget) : Row(label, layout));
+            } else if (!labelText.isNull()) {
+                form << (widget ? Row(labelText, widget) : Row(labelText, layout));
+            } else {
+                form << (widget ? Row(widget) : Row(layout));
+            }
+        }
+        return form;
+    }
+};
@@ -0,0 +1,517 @@
+#pragma once
+
+#include <QBoxLayout>
+#include <QStyle>
+#include <QVector>
+#include <QWidget>
+
+#include <utility>
+
+/**
+ * @brief Caching box layout engine which can be used as a backend of VBox and
+ * HBox layout wrappers instead of QVBoxLayout and QHBoxLayout.
+ *
+ * LinearLayout keeps the items, stretch factors and the whole API of
+ * QBoxLayout, it only replaces the size and geometry computations. Minimum
+ * sizes, size hints, maximum sizes, stretch factors and expanding flags of
+ * all items are cached in one contiguous array. Qt invalidates all items of a
+ * layout when it is activated, so the layout cannot tell which items changed.
+ * After an invalidation the sizes of all items are read again into the reused
+ * array (widget items cache the hints of their widgets, so this is cheap for
+ * unchanged widgets) and the cached totals are adjusted only by the items
+ * whose values differ. Setting the geometry (i.e. every step of an
+ * interactive resize) distributes the space in one pass over the cached
+ * array, without querying the items and without any allocation.
+ *
+ * The space distribution follows QBoxLayout, with one difference: when there
+ * is less space than the minimum size of the layout, all items are shrunk
+ * proportionally to their minimum sizes. Style-dependent spacing (i.e. when
+ * spacing() returns -1) is resolved when the items are read, like QBoxLayout
+ * does, from the layout spacing of the style between the control types of
+ * each pair of adjacent items. Layouts with items which have height for
+ * width fall back to the QBoxLayout implementation.
+ */
+class LinearLayout : public QBoxLayout
+{
+public:
+    explicit LinearLayout(Direction direction, QWidget *parent = nullptr)
+        : QBoxLayout(direction, parent)
+    {}
+
+    QSize sizeHint() const override
+    {
+        return isCached() ? m_sizeHint : QBoxLayout::sizeHint();
+    }
+
+    QSize minimumSize() const override
+    {
+        return isCached() ? m_minimumSize : QBoxLayout::minimumSize();
+    }
+
+    QSize maximumSize() const override
+    {
+        if (!isCached()) {
+            return QBoxLayout::maximumSize();
+        }
+
+        QSize size = m_maximumSize.boundedTo(QSize(QLAYOUTSIZE_MAX, QLAYOUTSIZE_MAX));
+        if (alignment() & Qt::AlignHorizontal_Mask) {
+            size.setWidth(QLAYOUTSIZE_MAX);
+        }
+        if (alignment() & Qt::AlignVertical_Mask) {
+            size.setHeight(QLAYOUTSIZE_MAX);
+        }
+        return size;
+    }
+
+    Qt::Orientations expandingDirections() const override
+    {
+        return isCached() ? m_expanding : QBoxLayout::expandingDirections();
+    }
+
+    bool hasHeightForWidth() const override
+    {
+        return isCached() ? false : QBoxLayout::hasHeightForWidth();
+    }
+
+    void invalidate() override
+    {
+        m_dirty = true;
+        m_geometryDirty = true;
+        QBoxLayout::invalidate();
+    }
+
+    void setGeometry(const QRect &rect) override
+    {
+        if (!isCached()) {
+            QBoxLayout::setGeometry(rect);
+            return;
+        }
+
+        if (!m_geometryDirty && rect == geometry()) {
+            return;
+        }
+        m_geometryDirty = false;
+
+        QLayout::setGeometry(rect);
+
+        int left, top, right, bottom;
+        getContentsMargins(&left, &top, &right, &bottom);
+        const QRect aligned = alignment() ? alignmentRect(rect) : rect;
+        const QRect s(aligned.x() + left,
+                      aligned.y() + top,
+                      aligned.width() - (left + right),
+                      aligned.height() - (top + bottom));
+
+        Direction visualDirection = direction();
+        QWidget *parent = parentWidget();
+        if (parent && parent->layoutDirection() == Qt::RightToLeft) {
+            if (visualDirection == LeftToRight) {
+                visualDirection = RightToLeft;
+            } else if (visualDirection == RightToLeft) {
+                visualDirection = LeftToRight;
+            }
+        }
+
+        const bool horizontal = isHorizontal();
+        const int start = horizontal ? s.x() : s.y();
+        distribute(start, horizontal ? s.width() : s.height());
+
+        for (const Item &data : qAsConst(m_items)) {
+            switch (visualDirection) {
+            case LeftToRight:
+                data.item->setGeometry(QRect(data.position, s.y(), data.size, s.height()));
+                break;
+            case RightToLeft:
+                data.item->setGeometry(QRect(s.left() + s.right() - data.position - data.size + 1,
+                                             s.y(),
+                                             data.size,
+                                             s.height()));
+                break;
+            case TopToBottom:
+                data.item->setGeometry(QRect(s.x(), data.position, s.width(), data.size));
+                break;
+            case BottomToTop:
+                data.item->setGeometry(QRect(s.x(),
+                                             s.top() + s.bottom() - data.position - data.size + 1,
+                                             s.width(),
+                                             data.size));
+                break;
+            }
+        }
+    }
+
+private:
+    struct Item
+    {
+        QLayoutItem *item = nullptr;
+        int minimum = 0;
+        int hint = 0;
+        int maximum = 0;
+        int stretch = 0;
+        bool expansive = false;
+        bool empty = true;
+        bool ignored = false;
+        bool spaced = false;
+
+        // Spacing to the next non-empty item, if spaced.
+        int spacing = 0;
+
+        // Results of the last space distribution.
+        int size = 0;
+        int position = 0;
+        bool done = false;
+
+        int smartHint() const { return stretch > 0 ? minimum : hint; }
+    };
+
+    bool isHorizontal() const
+    {
+        return direction() == LeftToRight || direction() == RightToLeft;
+    }
+
+    bool isCached() const
+    {
+        refresh();
+        return !m_fallback;
+    }
+
+    // Updates the cached item data after invalidation. The item array is
+    // rebuilt only if the items themselves changed. Otherwise the values of
+    // all items are read again and the totals are adjusted by the differences
+    // to the cached values.
+    void refresh() const
+    {
+        if (!m_dirty) {
+            return;
+        }
+        m_dirty = false;
+
+        const int n = count();
+        const int fixedSpacing = spacing();
+        QWidget *parent = parentWidget();
+        QStyle *style = fixedSpacing < 0 && parent ? parent->style() : nullptr;
+        m_fallback = false;
+
+        bool rebuild = n != m_items.size();
+        for (int i = 0; !rebuild && i < n; ++i) {
+            rebuild = m_items.at(i).item != itemAt(i);
+        }
+        if (rebuild) {
+            m_items.resize(n);
+            m_sumMinimum = m_sumHint = m_sumMaximum = 0;
+            for (int i = 0; i < n; ++i) {
+                m_items[i] = Item();
+                m_items[i].item = itemAt(i);
+            }
+        }
+
+        const bool horizontal = isHorizontal();
+        const Qt::Orientation orientation = horizontal ? Qt::Horizontal : Qt::Vertical;
+
+        int crossMinimum = 0;
+        int crossHint = 0;
+        int crossMaximum = QLAYOUTSIZE_MAX;
+        bool crossExpanding = false;
+        bool crossEmpty = true;
+        bool expanding = false;
+        int previous = -1;
+        int sumSpacing = 0;
+
+        for (int i = 0; i < n; ++i) {
+            Item &data = m_items[i];
+            QLayoutItem *item = data.item;
+            if (item->hasHeightForWidth()) {
+                m_fallback = true;
+            }
+
+            const bool empty = item->isEmpty();
+            const bool ignored = empty && item->widget();
+            // Hidden widgets take no space, but they are still given their
+            // (empty) geometry like in QBoxLayout.
+            int minimum = 0;
+            int hint = 0;
+            int maximum = ignored ? QLAYOUTSIZE_MAX : 0;
+            int stretchFactor = 0;
+            bool expansive = false;
+
+            if (!ignored) {
+                const QSize min = item->minimumSize();
+                const QSize max = item->maximumSize();
+                const QSize sh = item->sizeHint();
+                const Qt::Orientations directions = item->expandingDirections();
+
+                minimum = horizontal ? min.width() : min.height();
+                hint = horizontal ? sh.width() : sh.height();
+                maximum = horizontal ? max.width() : max.height();
+                expansive = directions & orientation;
+
+                stretchFactor = stretch(i);
+                if (stretchFactor == 0 && item->widget()) {
+                    const QSizePolicy policy = item->widget()->sizePolicy();
+                    stretchFactor = horizontal ? policy.horizontalStretch() : policy.verticalStretch();
+                }
+
+                expanding = expanding || expansive || stretchFactor > 0;
+                crossMinimum = qMax(crossMinimum, horizontal ? min.height() : min.width());
+                crossHint = qMax(crossHint, horizontal ? sh.height() : sh.width());
+                maxExpCalc(crossMaximum,
+                            crossExpanding,
+                            crossEmpty,
+                            horizontal ? max.height() : max.width(),
+                            directions & (horizontal ? Qt::Vertical : Qt::Horizontal),
+                            empty);
+            }
+
+            m_sumMinimum += minimum - data.minimum;
+            m_sumHint += hint - data.hint;
+            m_sumMaximum += (ignored ? 0 : qint64(maximum)) - (data.ignored ? 0 : data.maximum);
+
+            data.minimum = minimum;
+            data.hint = hint;
+            data.maximum = maximum;
+            data.stretch = stretchFactor;
+            data.expansive = expansive;
+            data.empty = empty;
+            data.ignored = ignored;
+            data.spaced = false;
+            data.spacing = 0;
+
+            if (!empty) {
+                if (previous >= 0) {
+                    Item &before = m_items[previous];
+                    before.spaced = true;
+                    before.spacing = fixedSpacing >= 0
+                                         ? fixedSpacing
+                                         : styleSpacing(style, before.item, item, orientation);
+                    sumSpacing += before.spacing;
+                }
+                previous = i;
+            }
+        }
+        if (m_fallback) {
+            sumSpacing = 0;
+        }
+        const int mainMinimum = m_sumMinimum + sumSpacing;
+        const int mainHint = qMax(m_sumHint + sumSpacing, mainMinimum);
+        const int mainMaximum = int(qBound<qint64>(mainMinimum, m_sumMaximum + sumSpacing, QLAYOUTSIZE_MAX));
+        crossMaximum = qMax(crossMaximum, crossMinimum);
+        crossHint = qMax(crossHint, crossMinimum);
+
+        int left, top, right, bottom;
+        getContentsMargins(&left, &top, &right, &bottom);
+        const QSize extra(left + right, top + bottom);
+
+        if (horizontal) {
+            m_minimumSize = QSize(mainMinimum, crossMinimum);
+            m_maximumSize = QSize(mainMaximum, crossMaximum);
+            m_sizeHint = QSize(mainHint, crossHint).boundedTo(m_maximumSize);
+            m_expanding = (expanding ? Qt::Horizontal : Qt::Orientations())
+                          | (crossExpanding ? Qt::Vertical : Qt::Orientations());
+        } else {
+            m_minimumSize = QSize(crossMinimum, mainMinimum);
+            m_maximumSize = QSize(crossMaximum, mainMaximum);
+            m_sizeHint = QSize(crossHint, mainHint).boundedTo(m_maximumSize);
+            m_expanding = (expanding ? Qt::Vertical : Qt::Orientations())
+                          | (crossExpanding ? Qt::Horizontal : Qt::Orientations());
+        }
+        m_minimumSize += extra;
+        m_maximumSize += extra;
+        m_sizeHint += extra;
+    }
+
+    /**
+     * @brief Returns the spacing of the style between two adjacent items, as
+     * QBoxLayout computes it for layouts without explicit spacing.
+     */
+    int styleSpacing(QStyle *style, QLayoutItem *first, QLayoutItem *second,
+                     Qt::Orientation orientation) const
+    {
+        if (!style) {
+            return 0;
+        }
+        QSizePolicy::ControlTypes before = first->controlTypes();
+        QSizePolicy::ControlTypes after = second->controlTypes();
+        if (direction() == RightToLeft || direction() == BottomToTop) {
+            std::swap(before, after);
+        }
+        return qMax(0, style->combinedLayoutSpacing(before, after, orientation, nullptr,
+                                                     parentWidget()));
+    }
+
+    static void maxExpCalc(int &max, bool &exp, bool &empty, int boxMax, bool boxExp, bool boxEmpty)
+    {
+        if (exp) {
+            if (boxExp) {
+                max = qMax(max, boxMax);
+            }
+        } else {
+            if (boxExp || (empty && (!boxEmpty || max == 0))) {
+                max = boxMax;
+            } else if (empty == boxEmpty) {
+                max = qMin(max, boxMax);
+            }
+        }
+        exp = exp || boxExp;
+        empty = empty && boxEmpty;
+    }
+
+    // Distributes the space along the main axis among the cached items and
+    // computes their positions. Sizes are distributed in fixed point with 6
+    // fractional bits and the rounding error is carried to the next item.
+    void distribute(int start, int space) const
+    {
+        int sumSpacing = 0;
+        int sumSmartHint = 0;
+        int sumStretch = 0;
+        int remaining = 0;
+        bool wannaGrow = false;
+        bool allEmptyNonStretch = true;
+
+        for (Item &data : m_items) {
+            data.done = false;
+            sumSmartHint += data.smartHint();
+            sumStretch += data.stretch;
+            if (data.spaced) {
+                sumSpacing += data.spacing;
+            }
+            wannaGrow = wannaGrow || data.expansive || data.stretch > 0;
+            allEmptyNonStretch = allEmptyNonStretch && !wannaGrow && data.empty;
+            ++remaining;
+        }
+
+        int extraSpace = 0;
+        int spaceLeft = space - sumSpacing;
+
+        auto fix = [&](Item &data, int size) {
+            data.size = size;
+            data.done = true;
+            spaceLeft -= size;
+            sumStretch -= data.stretch;
+            --remaining;
+        };
+
+        if (space < m_sumMinimum + sumSpacing) {
+            // Less space than the minimum size, shrink proportionally.
+            const qint64 available = qMax(0, spaceLeft);
+            qint64 carry = 0;
+            for (Item &data : m_items) {
+                carry += available * data.minimum * 64 / qMax(1, m_sumMinimum);
+                data.size = int((carry + 32) / 64);
+                carry -= qint64(data.size) * 64;
+            }
+        } else if (space < sumSmartHint + sumSpacing) {
+            // Less space than the size hint, take it equally from all items
+            // which can shrink.
+            int overdraft = sumSmartHint - spaceLeft;
+            for (Item &data : m_items) {
+                if (data.minimum >= data.smartHint()) {
+                    fix(data, data.smartHint());
+                }
+            }
+            bool finished = remaining == 0;
+            while (!finished) {
+                finished = true;
+                const qint64 over = qint64(overdraft) * 64;
+                qint64 carry = 0;
+                const int n = remaining;
+                for (Item &data : m_items) {
+                    if (data.done) {
+                        continue;
+                    }
+                    carry += over / n;
+                    const int w = int((carry + 32) / 64);
+                    data.size = data.smartHint() - w;
+                    carry -= qint64(w) * 64;
+                    if (data.size < data.minimum) {
+                        overdraft -= data.smartHint() - data.minimum;
+                        fix(data, data.minimum);
+                        finished = false;
+                        break;
+                    }
+                }
+            }
+        } else {
+            // More space than the size hint, first fix the items which do not
+            // want to grow, then distribute the rest by stretch factors.
+            for (Item &data : m_items) {
+                if (data.maximum <= data.smartHint()
+                    || (wannaGrow && !data.expansive && data.stretch == 0)
+                    || (!allEmptyNonStretch && data.empty && !data.expansive
+                        && data.stretch == 0)) {
+                    fix(data, data.smartHint());
+                }
+            }
+
+            int surplus = 0;
+            int deficit = 0;
+            do {
+                surplus = deficit = 0;
+                const qint64 available = qint64(spaceLeft) * 64;
+                qint64 carry = 0;
+                const int n = remaining;
+                for (Item &data : m_items) {
+                    if (data.done) {
+                        continue;
+                    }
+                    carry += sumStretch > 0 ? available * data.stretch / sumStretch : available / n;
+                    const int w = int((carry + 32) / 64);
+                    data.size = w;
+                    carry -= qint64(w) * 64;
+                    if (w < data.smartHint()) {
+                        deficit += data.smartHint() - w;
+                    } else if (w > data.maximum) {
+                        surplus += w - data.maximum;
+                    }
+                }
+                if (deficit > 0 && surplus <= deficit) {
+                    for (Item &data : m_items) {
+                        if (!data.done && data.size < data.smartHint()) {
+                            fix(data, data.smartHint());
+                        }
+                    }
+                }
+                if (surplus > 0 && surplus >= deficit) {
+                    for (Item &data : m_items) {
+                        if (!data.done && data.size > data.maximum) {
+                            fix(data, data.maximum);
+                        }
+                    }
+                }
+            } while (remaining > 0 && surplus != deficit);
+
+            if (remaining == 0) {
+                extraSpace = spaceLeft;
+            }
+        }
+
+        // Space which could not be given to any item is spread around and
+        // between the items.
+        int spacings = 0;
+        for (const Item &data : qAsConst(m_items)) {
+            spacings += data.spaced ? 1 : 0;
+        }
+        const int extra = extraSpace / (spacings + 2);
+
+        int position = start + extra;
+        for (Item &data : m_items) {
+            data.position = position;
+            position += data.size;
+            if (data.spaced) {
+                position += data.spacing + extra;
+            }
+        }
+    }
+
+    mutable QVector<Item> m_items;
+    mutable qint64 m_sumMaximum = 0;
+    mutable int m_sumMinimum = 0;
+    mutable int m_sumHint = 0;
+    mutable QSize m_minimumSize;
+    mutable QSize m_maximumSize;
+    mutable QSize m_sizeHint;
+    mutable Qt::Orientations m_expanding;
+    mutable bool m_fallback = false;
+    mutable bool m_dirty = true;
+    bool m_geometryDirty = true;
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QLayout>
+#include <QScreen>
+#include <QTimerEvent>
+#include <QWidget>
+#include <QWindow>
+
+#include <algorithm>
+#include <utility>
+
+/**
+ * @brief Opt-in coalescing of resizes of top-level layouts, i.e. layouts
+ * created by wrappers with a parent widget. During an interactive resize,
+ * e.g. a window drag, the parent widget gets many resize events per frame and
+ * each of them sets the geometry of the whole layout hierarchy. When enabled,
+ * such wrappers create layouts which do at most one pass per frame interval.
+ * A resize within the frame interval after the last pass is only remembered,
+ * and the latest remembered size is laid out when the interval elapses, so
+ * the final size is always laid out exactly once the resizing stops.
+ *
+ * Passes caused by an invalidation of the layout, e.g. by updateGeometry()
+ * of any of its widgets, are never deferred. The frame interval is derived
+ * from the refresh rate of the screen of the parent widget's window, unless
+ * it is set explicitly.
+ *
+ * Coalescing must be enabled before the layouts are created. It is meant to
+ * be used from the GUI thread only:
+ *
+ * ResizeCoalescing::setEnabled(true);
+ * VBox(mainWindow) << ...;
+ * ...
+ * qInfo() << ResizeCoalescing::passCount() << ResizeCoalescing::collapsedCount();
+ */
+class ResizeCoalescing final
+{
+public:
+    /**
+     * @brief Enables or disables coalescing for top-level layouts created by
+     * layout wrappers from now on. Disabled by default.
+     */
+    static void setEnabled(bool enabled) { s_enabled = enabled; }
+
+    static bool isEnabled() { return s_enabled; }
+
+    /**
+     * @brief Sets the frame interval in milliseconds. Default value 0 means
+     * that the interval is derived from the screen refresh rate.
+     */
+    static void setFrameInterval(int milliseconds) { s_frameInterval = milliseconds; }
+
+    /**
+     * @brief Returns the frame interval in milliseconds used for layouts of
+     * the widget, or of the primary screen if widget is nullptr.
+     */
+    static int frameInterval(const QWidget *widget = nullptr)
+    {
+        if (s_frameInterval > 0) {
+            return s_frameInterval;
+        }
+        QScreen *screen = QGuiApplication::primaryScreen();
+        if (widget) {
+            if (QWindow *window = widget->window()->windowHandle()) {
+                screen = window->screen();
+            }
+        }
+        const qreal rate = screen && screen->refreshRate() > 0 ? screen->refreshRate() : 60;
+        return std::max(1, qRound(1000 / rate));
+    }
+
+    /**
+     * @brief Returns the number of passes done by coalescing layouts, i.e.
+     * setGeometry() calls of the layout hierarchies.
+     */
+    static int passCount() { return s_passCount; }
+
+    /**
+     * @brief Returns the number of resizes which were collapsed into a later
+     * pass instead of being laid out immediately.
+     */
+    static int collapsedCount() { return s_collapsedCount; }
+
+    static void resetCounters()
+    {
+        s_passCount = 0;
+        s_collapsedCount = 0;
+    }
+
+private:
+    template<typename Layout_T>
+    friend class CoalescingLayout;
+
+    inline static bool s_enabled = false;
+    inline static int s_frameInterval = 0;
+    inline static int s_passCount = 0;
+    inline static int s_collapsedCount = 0;
+};
+
+/**
+ * @brief Layout coalescing resizes, see ResizeCoalescing. Layout wrappers
+ * create it instead of Layout_T for top-level layouts when coalescing is
+ * enabled.
+ */
+template<typename Layout_T>
+class CoalescingLayout : public Layout_T
+{
+public:
+    template<typename... Args_T>
+    explicit CoalescingLayout(Args_T &&...args)
+        : Layout_T(std::forward<Args_T>(args)...)
+    {}
+
+    void setGeometry(const QRect &rect) override
+    {
+        const int interval = ResizeCoalescing::frameInterval(this->parentWidget());
+        if (m_invalidated || !m_lastPass.isValid() || m_lastPass.elapsed() >= interval) {
+            pass(rect);
+            return;
+        }
+
+        m_pending = rect;
+        ++ResizeCoalescing::s_collapsedCount;
+        if (m_timerId == 0) {
+            const int remaining = std::max(0, interval - int(m_lastPass.elapsed()));
+            m_timerId = this->startTimer(remaining, Qt::PreciseTimer);
+        }
+    }
+
+    void invalidate() override
+    {
+        m_invalidated = true;
+        Layout_T::invalidate();
+    }
+
+protected:
+    void timerEvent(QTimerEvent *event) override
+    {
+        if (event->timerId() != m_timerId) {
+            Layout_T::timerEvent(event);
+            return;
+        }
+        pass(m_pending);
+    }
+
+private:
+    void pass(const QRect &rect)
+    {
+        if (m_timerId != 0) {
+            this->killTimer(m_timerId);
+            m_timerId = 0;
+        }
+        m_invalidated = false;
+        m_lastPass.start();
+        Layout_T::setGeometry(rect);
+        ++ResizeCoalescing::s_passCount;
+    }
+
+    QElapsedTimer m_lastPass;
+    QRect m_pending;
+    bool m_invalidated = false;
+    int m_timerId = 0;
+};
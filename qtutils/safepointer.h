@@ -4,6 +4,10 @@
 // https://github.com/vladimir-kraus/qtutils
 //
 
+#pragma once
+
+#include <QPointer>
+
 /*
  * SafePointer is a strong pointer specialized for QObject-based classes.
  * SafePointer owns the object in the sense that when the pointer gets destroyed,
@@ -64,8 +68,8 @@ public:
      */
     T *release()
     {
-        T *p = data();
-        clear();
+        T *p = this->data();
+        this->clear();
         return p;
     }
 
@@ -82,9 +86,9 @@ public:
      */
     void resetLater()
     {
-        if (data() != nullptr)
+        if (this->data() != nullptr)
         {
-            data()->deleteLater();
+            this->data()->deleteLater();
         }
     }
 
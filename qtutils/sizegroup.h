@@ -0,0 +1,362 @@
+#pragma once
+
+#include <QBoxLayout>
+#include <QCoreApplication>
+#include <QFormLayout>
+#include <QLayout>
+#include <QLayoutItem>
+#include <QMap>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "layouts.h"
+
+//
+// Size groups give widgets of separate layouts the same size hint, which is
+// the largest size hint of the group's members, e.g. to align label columns
+// of several forms without hand-computed fixed widths:
+//
+// SizeGroup labels;
+// VBox(dialog)
+//     << (Form().setLabelGroup(labels) << Row(tr("Name"), nameEdit))
+//     << (Form().setLabelGroup(labels) << Row(tr("E-mail address"), emailEdit))
+//     << (HBox() << Grouped(new QLabel(tr("Notes")), labels) << notesEdit);
+//
+
+class SizeGroupItem;
+
+/**
+ * @brief Group of widgets sharing the largest size hint in the given
+ * orientations. It is a handle, copies refer to the same group, and the
+ * group lives as long as any of its copies or member items.
+ *
+ * Members are layout items which replace the widget items of the member
+ * widgets in their layouts, see Grouped and Form::setLabelGroup(). The
+ * largest hint is cached in sorted counts of the member hints. When a
+ * member is invalidated, i.e. when its layout is activated, only its own
+ * hint is computed again and the counts are updated, so no query rescans
+ * the other members. If the largest hint changes, the layouts of members
+ * which are not being laid out at the moment are invalidated from the next
+ * event loop iteration, since the change is found during a size query.
+ *
+ * Hidden members do not contribute to the group. A removed member does not
+ * shrink the other members before their layouts are laid out again.
+ */
+class SizeGroup final
+{
+public:
+    explicit SizeGroup(Qt::Orientations orientations = Qt::Horizontal)
+        : d(std::make_shared<Data>())
+    {
+        d->orientations = orientations;
+    }
+
+    Qt::Orientations orientations() const { return d->orientations; }
+
+    /**
+     * @brief Returns the number of member items.
+     */
+    int count() const { return d->members.size(); }
+
+    /**
+     * @brief Returns the largest size hint of the visible members.
+     */
+    QSize sizeHint() const
+    {
+        d->update();
+        return d->maximum().expandedTo(QSize(0, 0));
+    }
+
+    /**
+     * @brief Makes the widget a member of the group, by replacing its widget
+     * item in the layout with a member item at the same position. The layout
+     * can be a QBoxLayout or a QFormLayout. Returns false if the widget is not
+     * an item of the layout.
+     */
+    bool adopt(QLayout *layout, QWidget *widget) const;
+
+    /**
+     * @brief Returns the number of member size hints computed by all groups.
+     */
+    static int memberUpdateCount() { return s_memberUpdateCount; }
+
+    static void resetCounters() { s_memberUpdateCount = 0; }
+
+private:
+    friend class SizeGroupItem;
+
+    struct Data : std::enable_shared_from_this<Data>
+    {
+        void add(SizeGroupItem *item);
+        void remove(SizeGroupItem *item);
+        void setDirty(SizeGroupItem *item);
+        void update();
+        void invalidateLater(QLayout *layout);
+        void invalidateStale();
+
+        /**
+         * @brief Returns the largest counted hint, -1 in orientations without
+         * counted hints.
+         */
+        QSize maximum() const
+        {
+            return QSize(widths.isEmpty() ? -1 : widths.lastKey(),
+                         heights.isEmpty() ? -1 : heights.lastKey());
+        }
+
+        static void count(QMap<int, int> &counts, int value, int delta)
+        {
+            int &count = counts[value];
+            count += delta;
+            if (count == 0) {
+                counts.remove(value);
+            }
+        }
+
+        Qt::Orientations orientations;
+        QSet<SizeGroupItem *> members;
+        QVector<SizeGroupItem *> dirty;
+        QMap<int, int> widths;
+        QMap<int, int> heights;
+        QVector<QPointer<QLayout>> stale;
+    };
+
+    explicit SizeGroup(std::shared_ptr<Data> data)
+        : d(std::move(data))
+    {}
+
+    std::shared_ptr<Data> d;
+
+    inline static int s_memberUpdateCount = 0;
+};
+
+/**
+ * @brief Widget item of a SizeGroup member. Its size hint is the own size
+ * hint of the widget expanded to the largest hint of the group.
+ */
+class SizeGroupItem final : public QWidgetItem
+{
+public:
+    SizeGroupItem(QWidget *widget, QLayout *layout, const SizeGroup &group)
+        : QWidgetItem(widget)
+        , m_layout(layout)
+        , m_group(group.d)
+    {
+        m_group->add(this);
+    }
+
+    ~SizeGroupItem() override { m_group->remove(this); }
+
+    QSize sizeHint() const override
+    {
+        QSize hint = QWidgetItem::sizeHint();
+        if (isEmpty()) {
+            return hint;
+        }
+        m_group->update();
+        const QSize maximum = m_group->maximum();
+        if (m_group->orientations & Qt::Horizontal) {
+            hint.setWidth(qMax(hint.width(), maximum.width()));
+        }
+        if (m_group->orientations & Qt::Vertical) {
+            hint.setHeight(qMax(hint.height(), maximum.height()));
+        }
+        return hint;
+    }
+
+    void invalidate() override
+    {
+        m_group->setDirty(this);
+        QWidgetItem::invalidate();
+    }
+
+    SizeGroup group() const { return SizeGroup(m_group); }
+
+private:
+    friend struct SizeGroup::Data;
+
+    QLayout *m_layout;
+    std::shared_ptr<SizeGroup::Data> m_group;
+    QSize m_hint;
+    bool m_dirty = false;
+};
+
+inline void SizeGroup::Data::add(SizeGroupItem *item)
+{
+    members.insert(item);
+    setDirty(item);
+}
+
+inline void SizeGroup::Data::remove(SizeGroupItem *item)
+{
+    if (item->m_hint.isValid()) {
+        count(widths, item->m_hint.width(), -1);
+        count(heights, item->m_hint.height(), -1);
+    }
+    if (item->m_dirty) {
+        dirty.removeOne(item);
+    }
+    members.remove(item);
+}
+
+inline void SizeGroup::Data::setDirty(SizeGroupItem *item)
+{
+    if (!item->m_dirty) {
+        item->m_dirty = true;
+        dirty.append(item);
+    }
+}
+
+inline void SizeGroup::Data::update()
+{
+    if (dirty.isEmpty()) {
+        return;
+    }
+
+    const QSize previous = maximum();
+    for (SizeGroupItem *item : qAsConst(dirty)) {
+        const QSize hint = item->isEmpty() ? QSize() : item->QWidgetItem::sizeHint();
+        ++s_memberUpdateCount;
+        if (hint == item->m_hint) {
+            continue;
+        }
+        if (item->m_hint.isValid()) {
+            count(widths, item->m_hint.width(), -1);
+            count(heights, item->m_hint.height(), -1);
+        }
+        if (hint.isValid()) {
+            count(widths, hint.width(), 1);
+            count(heights, hint.height(), 1);
+        }
+        item->m_hint = hint;
+    }
+
+    // Dirty members are being laid out, the layouts of the other members
+    // still use the previous largest hint.
+    const QSize current = maximum();
+    const bool changed = ((orientations & Qt::Horizontal) && current.width() != previous.width())
+                         || ((orientations & Qt::Vertical) && current.height() != previous.height());
+    if (changed) {
+        for (SizeGroupItem *item : qAsConst(members)) {
+            if (!item->m_dirty) {
+                invalidateLater(item->m_layout);
+            }
+        }
+    }
+    for (SizeGroupItem *item : qAsConst(dirty)) {
+        item->m_dirty = false;
+    }
+    dirty.clear();
+}
+
+/**
+ * @brief Invalidates the layout from the next event loop iteration. Updates
+ * run from size queries, and invalidating other layouts while a layout
+ * computes its size would make Qt relayout within the pass.
+ */
+inline void SizeGroup::Data::invalidateLater(QLayout *layout)
+{
+    if (stale.contains(layout)) {
+        return;
+    }
+    if (stale.isEmpty() && qApp) {
+        std::weak_ptr<Data> weak = shared_from_this();
+        QTimer::singleShot(0, qApp, [weak] {
+            if (const std::shared_ptr<Data> data = weak.lock()) {
+                data->invalidateStale();
+            }
+        });
+    }
+    stale.append(layout);
+}
+
+inline void SizeGroup::Data::invalidateStale()
+{
+    const QVector<QPointer<QLayout>> layouts = std::exchange(stale, {});
+    for (const QPointer<QLayout> &layout : layouts) {
+        if (layout) {
+            layout->invalidate();
+        }
+    }
+}
+
+inline bool SizeGroup::adopt(QLayout *layout, QWidget *widget) const
+{
+    if (auto box = qobject_cast<QBoxLayout *>(layout)) {
+        const int index = box->indexOf(widget);
+        if (index < 0) {
+            return false;
+        }
+        const int stretch = box->stretch(index);
+        QLayoutItem *item = box->takeAt(index);
+        auto member = new SizeGroupItem(widget, box, *this);
+        member->setAlignment(item->alignment());
+        delete item;
+        box->insertItem(index, member);
+        box->setStretch(index, stretch);
+        return true;
+    }
+    if (auto form = qobject_cast<QFormLayout *>(layout)) {
+        int row = -1;
+        QFormLayout::ItemRole role = QFormLayout::LabelRole;
+        form->getWidgetPosition(widget, &row, &role);
+        if (row < 0) {
+            return false;
+        }
+        QLayoutItem *item = form->itemAt(row, role);
+        form->removeItem(item);
+        auto member = new SizeGroupItem(widget, form, *this);
+        member->setAlignment(item->alignment());
+        delete item;
+        form->setItem(row, role, member);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Adds a widget to a layout wrapper as a member of a SizeGroup,
+ * optionally stretched. Null widgets are ignored.
+ */
+class Grouped final
+{
+public:
+    Grouped(QWidget *widget, const SizeGroup &group, int stretch = 0)
+        : m_widget(widget)
+        , m_group(group)
+        , m_stretch(stretch)
+    {}
+
+    QWidget *widget() const { return m_widget; }
+
+    const SizeGroup &group() const { return m_group; }
+
+    int stretch() const { return m_stretch; }
+
+private:
+    QWidget *m_widget;
+    SizeGroup m_group;
+    int m_stretch;
+};
+
+/**
+ * @brief Adds a grouped widget to a VBox or HBox. The widget item is replaced
+ * with a member item right away, so pending children of a batched wrapper
+ * are committed first.
+ */
+template<typename Box_T, typename = std::enable_if_t<std::is_base_of<Box, std::decay_t<Box_T>>::value>>
+Box &operator<<(Box_T &&box, const Grouped &grouped)
+{
+    if (grouped.widget()) {
+        box << Stretched(grouped.widget(), grouped.stretch());
+        grouped.group().adopt(static_cast<QBoxLayout *>(box), grouped.widget());
+    }
+    return box;
+}
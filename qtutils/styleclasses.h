@@ -0,0 +1,193 @@
+#pragma once
+
+#include <QApplication>
+#include <QDebug>
+#include <QMap>
+#include <QStyle>
+#include <QWidget>
+
+#include <algorithm>
+
+//
+// Named style classes, which replace per-widget style sheets. Calling
+// setStyleSheet() on each widget makes Qt parse the sheet for each widget
+// separately and create a separate style object for each of them. Style
+// classes are instead registered once and collected into one sheet of the
+// application, which is parsed once and shared by all widgets. Widgets refer
+// to their classes by a dynamic property matched by the sheet's selectors:
+//
+// StyleClasses::define("card", "background: white; border: 1px solid gray;");
+// StyleClasses::define("warning", "color: darkred;");
+//
+// VBox(panel)
+//     << Styled(new QFrame(), "card")
+//     << Styled(new QLabel(tr("Disk is almost full")), "card warning");
+//
+// The classes are added to the application style sheet after any sheet set
+// by the application, so define all classes before widgets are created, to
+// let the application sheet be parsed only once. Classes redefined later
+// should be passed to define() together, so the sheet is parsed once for all
+// of them.
+//
+// Note that any application style sheet, including the one generated for
+// style classes, makes Qt style all widgets of the application through
+// QStyleSheetStyle, which is slower than the native style even for widgets
+// without any class. Style classes pay off when many widgets would get their
+// own sheets otherwise, not as a replacement of a palette or a custom style.
+//
+
+/**
+ * @brief Registry of named style classes, see Styled.
+ */
+class StyleClasses final
+{
+public:
+    /**
+     * @brief Name of the dynamic property holding the space separated style
+     * classes of a widget.
+     */
+    static constexpr const char *PropertyName = "styleClass";
+
+    /**
+     * @brief Defines or redefines a style class by style sheet declarations,
+     * e.g. "background: gray;". The application style sheet is updated when
+     * a class is applied to a widget for the next time. Class names may
+     * contain only letters, digits, '-' and '_', other names are ignored
+     * with a warning.
+     */
+    static void define(const QString &name, const QString &declarations)
+    {
+        if (isValidName(name)) {
+            s_classes.insert(name, declarations);
+            s_dirty = true;
+        }
+    }
+
+    /**
+     * @brief Defines or redefines several style classes, mapped from their
+     * names to their declarations, and updates the application style sheet
+     * right away, once for all of them.
+     */
+    static void define(const QMap<QString, QString> &classes)
+    {
+        for (auto it = classes.cbegin(); it != classes.cend(); ++it) {
+            define(it.key(), it.value());
+        }
+        update();
+    }
+
+    /**
+     * @brief Removes all style classes from the application style sheet.
+     */
+    static void clear()
+    {
+        s_classes.clear();
+        s_dirty = true;
+        update();
+    }
+
+    /**
+     * @brief Returns the style sheet generated from the style classes.
+     */
+    static QString styleSheet()
+    {
+        QString sheet;
+        for (auto it = s_classes.cbegin(); it != s_classes.cend(); ++it) {
+            sheet += QStringLiteral("*[%1~=\"%2\"] { %3 }\n")
+                         .arg(QLatin1String(PropertyName), it.key(), it.value());
+        }
+        return sheet;
+    }
+
+    /**
+     * @brief Sets space separated style classes of the widget. Widgets which
+     * are not polished yet, e.g. widgets which were not shown, get their
+     * style when they are polished, other widgets are polished again.
+     */
+    static void apply(QWidget *widget, const QString &classes)
+    {
+        update();
+        widget->setProperty(PropertyName, classes);
+        if (widget->testAttribute(Qt::WA_WState_Polished)) {
+            widget->style()->unpolish(widget);
+            widget->style()->polish(widget);
+        }
+    }
+
+private:
+    /**
+     * @brief Returns whether the name can be used in the selector of the
+     * class, i.e. it is one word of an identifier-like name. The property
+     * holds space separated names matched by "~=", so other characters would
+     * break the selector or the sheet.
+     */
+    static bool isValidName(const QString &name)
+    {
+        const bool valid = !name.isEmpty()
+                           && std::all_of(name.cbegin(), name.cend(), [](QChar c) {
+                                  return (c.unicode() < 128 && c.isLetterOrNumber())
+                                         || c == QLatin1Char('-') || c == QLatin1Char('_');
+                              });
+        if (!valid) {
+            qWarning() << "StyleClasses: ignoring invalid style class name" << name;
+        }
+        return valid;
+    }
+
+    /**
+     * @brief Replaces the section of style classes in the application style
+     * sheet if the classes changed.
+     */
+    static void update()
+    {
+        auto application = qobject_cast<QApplication *>(QCoreApplication::instance());
+        if (!s_dirty || !application) {
+            return;
+        }
+        s_dirty = false;
+
+        static const QString begin = QStringLiteral("/* qtutils style classes */\n");
+        static const QString end = QStringLiteral("/* end of qtutils style classes */\n");
+        QString sheet = application->styleSheet();
+        const int start = sheet.indexOf(begin);
+        if (start >= 0) {
+            const int stop = sheet.indexOf(end, start);
+            sheet.remove(start, stop >= 0 ? stop + end.size() - start : sheet.size() - start);
+        }
+        if (!s_classes.isEmpty()) {
+            sheet += begin + styleSheet() + end;
+        }
+        application->setStyleSheet(sheet);
+    }
+
+    inline static QMap<QString, QString> s_classes;
+    inline static bool s_dirty = false;
+};
+
+/**
+ * @brief Applies space separated style classes defined by StyleClasses to
+ * a widget. It converts to the widget, so it can be added to any layout
+ * wrapper, used in Stretched, Aligned or Row etc. Null widgets are ignored.
+ */
+template<typename T>
+class Styled final
+{
+public:
+    Styled(T *widget, const QString &classes)
+        : m_widget(widget)
+    {
+        if (widget) {
+            StyleClasses::apply(widget, classes);
+        }
+    }
+
+    /**
+     * @brief Implicit conversion to the styled widget.
+     */
+    operator T *() const { return m_widget; }
+
+    T *widget() const { return m_widget; }
+
+private:
+    T *m_widget;
+};
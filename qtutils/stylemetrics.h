@@ -0,0 +1,228 @@
+#pragma once
+
+#include <QBoxLayout>
+#include <QChildEvent>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QFormLayout>
+#include <QGridLayout>
+#include <QHash>
+#include <QLayout>
+#include <QPointer>
+#include <QStyle>
+#include <QWidget>
+
+/**
+ * @brief Opt-in resolution of default margins and spacing of layouts created
+ * by layout wrappers, i.e. Margins(-1) and Spacing(-1). Qt layouts resolve
+ * these defaults on every size computation, by asking the parent layouts for
+ * their spacing up to the top-level layout, which asks the style of its
+ * widget. When enabled, the wrappers replace the defaults by explicit values,
+ * taken from a cache of style metrics per style and device pixel ratio:
+ *
+ * - a top-level layout, i.e. a layout with a parent widget, gets the margins
+ *   and spacing of the widget's style,
+ * - a child layout gets the spacing of its parent layout when it is added to
+ *   a layout which was already resolved, like Qt does for child layouts.
+ *
+ * When the widget of a resolved top-level layout receives QEvent::StyleChange
+ * or QEvent::ScreenChangeInternal, the cache is cleared and the hierarchy is
+ * resolved again with the new metrics.
+ *
+ * The resolution must be enabled before the layouts are created. It is meant
+ * to be used from the GUI thread only:
+ *
+ * StyleMetrics::setEnabled(true);
+ * VBox(dialog, Margins()) << ...;
+ */
+class StyleMetrics final
+{
+public:
+    /**
+     * @brief Enables or disables the resolution for layouts created by
+     * layout wrappers from now on. Disabled by default.
+     */
+    static void setEnabled(bool enabled) { s_enabled = enabled; }
+
+    static bool isEnabled() { return s_enabled; }
+
+    /**
+     * @brief Returns the pixel metric of the widget's style from the cache,
+     * queries the style only on a cache miss.
+     */
+    static int pixelMetric(QStyle::PixelMetric metric, const QWidget *widget)
+    {
+        const Key key{ widget->style(), widget->devicePixelRatioF(), metric };
+        const auto it = s_metrics.constFind(key);
+        if (it != s_metrics.constEnd()) {
+            return *it;
+        }
+        const int value = widget->style()->pixelMetric(metric, nullptr, widget);
+        s_metrics.insert(key, value);
+        ++s_styleQueryCount;
+        return value;
+    }
+
+    /**
+     * @brief Clears the cache.
+     */
+    static void invalidate() { s_metrics.clear(); }
+
+    /**
+     * @brief Returns the number of style queries done on cache misses.
+     */
+    static int styleQueryCount() { return s_styleQueryCount; }
+
+    /**
+     * @brief Adopts a layout created by a layout wrapper with the given
+     * margins and spacing. Defaults are resolved now if the layout is a
+     * top-level layout, or when the layout is added to a resolved layout.
+     */
+    static void adopt(QLayout *layout, const QMargins &margins, int spacing)
+    {
+        const bool defaultMargins = margins.left() < 0 || margins.top() < 0
+                                    || margins.right() < 0 || margins.bottom() < 0;
+        if (defaultMargins) {
+            layout->setProperty(DefaultMargins, true);
+        }
+        if (spacing < 0) {
+            layout->setProperty(DefaultSpacing, true);
+        }
+        if (QWidget *widget = layout->parentWidget()) {
+            watch(widget);
+            resolveTopLevel(layout);
+        }
+    }
+
+private:
+    struct Key
+    {
+        const QStyle *style;
+        qreal ratio;
+        int metric;
+
+        bool operator==(const Key &other) const
+        {
+            return style == other.style && ratio == other.ratio && metric == other.metric;
+        }
+    };
+
+    friend uint qHash(const Key &key, uint seed = 0)
+    {
+        return qHash(key.style, seed) ^ qHash(key.ratio) ^ uint(key.metric);
+    }
+
+    /**
+     * @brief Resolves the spacing of child layouts added to resolved layouts
+     * and the whole hierarchy when the style of a top-level widget changes.
+     */
+    class Filter final : public QObject
+    {
+    public:
+        using QObject::QObject;
+
+        bool eventFilter(QObject *watched, QEvent *event) override
+        {
+            switch (event->type()) {
+            case QEvent::ChildAdded:
+                if (auto layout = qobject_cast<QLayout *>(watched)) {
+                    auto child = qobject_cast<QLayout *>(static_cast<QChildEvent *>(event)->child());
+                    if (child) {
+                        resolveChild(layout, child);
+                    }
+                }
+                break;
+            case QEvent::StyleChange:
+            case QEvent::ScreenChangeInternal:
+                if (watched->isWidgetType()) {
+                    if (QLayout *layout = static_cast<QWidget *>(watched)->layout()) {
+                        StyleMetrics::invalidate();
+                        resolveTopLevel(layout);
+                    }
+                }
+                break;
+            default:
+                break;
+            }
+            return false;
+        }
+    };
+
+    /**
+     * @brief Installs the filter to the object. The filter is created on
+     * first use as a child of the application, so it does not outlive it.
+     */
+    static void watch(QObject *object)
+    {
+        if (!s_filter && qApp) {
+            s_filter = new Filter(qApp);
+        }
+        if (s_filter) {
+            object->installEventFilter(s_filter);
+        }
+    }
+
+    static constexpr const char *DefaultMargins = "_qtutils_defaultMargins";
+    static constexpr const char *DefaultSpacing = "_qtutils_defaultSpacing";
+
+    static bool hasDefault(const QLayout *layout, const char *name)
+    {
+        return layout->property(name).toBool();
+    }
+
+    static void resolveTopLevel(QLayout *layout)
+    {
+        const QWidget *widget = layout->parentWidget();
+        if (hasDefault(layout, DefaultMargins)) {
+            layout->setContentsMargins(pixelMetric(QStyle::PM_LayoutLeftMargin, widget),
+                                       pixelMetric(QStyle::PM_LayoutTopMargin, widget),
+                                       pixelMetric(QStyle::PM_LayoutRightMargin, widget),
+                                       pixelMetric(QStyle::PM_LayoutBottomMargin, widget));
+        }
+        if (hasDefault(layout, DefaultSpacing)) {
+            const int horizontal = pixelMetric(QStyle::PM_LayoutHorizontalSpacing, widget);
+            const int vertical = pixelMetric(QStyle::PM_LayoutVerticalSpacing, widget);
+            if (auto box = qobject_cast<QBoxLayout *>(layout)) {
+                const bool isHorizontal = box->direction() == QBoxLayout::LeftToRight
+                                          || box->direction() == QBoxLayout::RightToLeft;
+                box->setSpacing(isHorizontal ? horizontal : vertical);
+            } else if (auto form = qobject_cast<QFormLayout *>(layout)) {
+                form->setHorizontalSpacing(horizontal);
+                form->setVerticalSpacing(vertical);
+            } else if (auto grid = qobject_cast<QGridLayout *>(layout)) {
+                grid->setHorizontalSpacing(horizontal);
+                grid->setVerticalSpacing(vertical);
+            } else if (horizontal == vertical) {
+                // Other layouts have one spacing only, keeps the default if
+                // the style has different ones.
+                layout->setSpacing(horizontal);
+            }
+        }
+        watch(layout);
+        resolveChildren(layout);
+    }
+
+    static void resolveChild(QLayout *parent, QLayout *child)
+    {
+        const int spacing = parent->spacing();
+        if (spacing >= 0 && hasDefault(child, DefaultSpacing)) {
+            child->setSpacing(spacing);
+        }
+        watch(child);
+        resolveChildren(child);
+    }
+
+    static void resolveChildren(QLayout *layout)
+    {
+        for (int i = 0; i < layout->count(); ++i) {
+            if (QLayout *child = layout->itemAt(i)->layout()) {
+                resolveChild(layout, child);
+            }
+        }
+    }
+
+    inline static bool s_enabled = false;
+    inline static int s_styleQueryCount = 0;
+    inline static QHash<Key, int> s_metrics;
+    inline static QPointer<Filter> s_filter;
+};
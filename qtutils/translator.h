@@ -3,6 +3,8 @@
 #include <QApplication>
 #include <QObject>
 
+#include "safeconnect.h"
+
 /**
  * Provides simple dynamic translations for widgets.
  * Translator object must be instantiated after QApplication is instantiated.
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <QAbstractScrollArea>
+#include <QHash>
+#include <QLabel>
+#include <QResizeEvent>
+#include <QScrollBar>
+#include <QStyle>
+#include <QVector>
+
+#include <algorithm>
+#include <functional>
+
+/**
+ * @brief Scrollable form with a large number of rows, which creates widgets
+ * only for the rows visible in the viewport (plus a few rows above and below,
+ * the overscan). Each row consists of a label and a field widget, like a row
+ * of Form. The widgets of rows scrolled out of view are reused for rows
+ * scrolling into view, so the number of widgets depends only on the height
+ * of the viewport.
+ *
+ * The field widgets are created by the field factory, which is called only
+ * when there is no unused field to reuse. The row binder then sets the label
+ * text and the content of the field for a particular row, each time a label
+ * and field are assigned to a row. All rows have the same height, given by
+ * the size hints of the label and the field of the first row. The width of
+ * the label column is the widest label seen so far.
+ * Usage:
+ * auto inspector = new VirtualForm(properties.size(),
+ *     [] { return new QLineEdit(); },
+ *     [&properties](int row, QLabel *label, QWidget *field) {
+ *         label->setText(properties[row].name);
+ *         static_cast<QLineEdit *>(field)->setText(properties[row].value);
+ *     });
+ */
+class VirtualForm : public QAbstractScrollArea
+{
+public:
+    using FieldFactory = std::function<QWidget *()>;
+    using RowBinder = std::function<void(int row, QLabel *label, QWidget *field)>;
+
+    VirtualForm(int rowCount, FieldFactory createField, RowBinder bindRow, QWidget *parent = nullptr)
+        : QAbstractScrollArea(parent)
+        , m_rowCount(rowCount)
+        , m_createField(std::move(createField))
+        , m_bindRow(std::move(bindRow))
+    {
+        measureRowHeight();
+    }
+
+    int rowCount() const { return m_rowCount; }
+
+    /**
+     * @brief Changes the number of rows and rebinds all visible rows.
+     */
+    void setRowCount(int rowCount)
+    {
+        m_rowCount = rowCount;
+        measureRowHeight();
+        reset();
+        updateGeometry();
+    }
+
+    /**
+     * @brief Sets the number of rows materialized above and below the
+     * viewport. Default is 4.
+     */
+    void setOverscan(int rows)
+    {
+        m_overscan = rows;
+        updateRows();
+    }
+
+    int overscan() const { return m_overscan; }
+
+    /**
+     * @brief Rebinds all materialized rows, e.g. when the data changed.
+     */
+    void reset()
+    {
+        for (auto it = m_rows.begin(); it != m_rows.end(); ++it) {
+            recycle(it.value());
+        }
+        m_rows.clear();
+        updateScrollBars();
+        updateRows();
+    }
+
+    /**
+     * @brief Rebinds one row if it is materialized.
+     */
+    void updateRow(int row)
+    {
+        const auto it = m_rows.constFind(row);
+        if (it != m_rows.constEnd()) {
+            bind(row, it.value());
+            updateRows();
+        }
+    }
+
+    /**
+     * @brief Returns the number of rows which currently have widgets.
+     */
+    int materializedRowCount() const { return m_rows.size(); }
+
+    /**
+     * @brief Returns the number of label and field pairs created so far.
+     */
+    int createdRowCount() const { return m_rows.size() + m_unused.size(); }
+
+    QSize sizeHint() const override
+    {
+        const int height = std::min(m_rowCount, 10) * rowHeight();
+        return QSize(QAbstractScrollArea::sizeHint().width(), height + 2 * frameWidth());
+    }
+
+protected:
+    void resizeEvent(QResizeEvent *event) override
+    {
+        QAbstractScrollArea::resizeEvent(event);
+        updateScrollBars();
+        updateRows();
+    }
+
+    void scrollContentsBy(int, int) override { updateRows(); }
+
+private:
+    struct Slot
+    {
+        QLabel *label;
+        QWidget *field;
+    };
+
+    int spacing(QStyle::PixelMetric metric) const
+    {
+        const int value = style()->pixelMetric(metric, nullptr, this);
+        return value >= 0 ? value : 6;
+    }
+
+    /**
+     * @brief Measures the height of all rows including the vertical spacing
+     * once there is a row. The first row is materialized to measure it, so
+     * this is done when the rows are set and never from size queries.
+     */
+    void measureRowHeight()
+    {
+        if (m_rowHeight > 0 || m_rowCount <= 0) {
+            return;
+        }
+        const Slot slot = acquire();
+        bind(0, slot);
+        m_rowHeight = std::max(slot.label->sizeHint().height(), slot.field->sizeHint().height())
+                      + spacing(QStyle::PM_LayoutVerticalSpacing);
+        recycle(slot);
+    }
+
+    int rowHeight() const { return std::max(m_rowHeight, 1); }
+
+    void updateScrollBars()
+    {
+        const int height = rowHeight();
+        QScrollBar *scrollBar = verticalScrollBar();
+        scrollBar->setRange(0, std::max(0, m_rowCount * height - viewport()->height()));
+        scrollBar->setPageStep(viewport()->height());
+        scrollBar->setSingleStep(height);
+    }
+
+    /**
+     * @brief Recycles the rows which left the viewport and materializes the
+     * rows which entered it, then positions all materialized rows.
+     */
+    void updateRows()
+    {
+        if (m_rowCount <= 0) {
+            return;
+        }
+
+        const int height = rowHeight();
+        const int offset = verticalScrollBar()->value();
+        const int first = std::max(0, offset / height - m_overscan);
+        const int last = std::min(m_rowCount - 1,
+                                  (offset + viewport()->height()) / height + m_overscan);
+
+        for (auto it = m_rows.begin(); it != m_rows.end();) {
+            if (it.key() < first || it.key() > last) {
+                recycle(it.value());
+                it = m_rows.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (int row = first; row <= last; ++row) {
+            if (!m_rows.contains(row)) {
+                const Slot slot = acquire();
+                bind(row, slot);
+                m_rows.insert(row, slot);
+            }
+        }
+
+        const int horizontalSpacing = spacing(QStyle::PM_LayoutHorizontalSpacing);
+        const int fieldWidth = std::max(0, viewport()->width() - m_labelWidth - horizontalSpacing);
+        const int rowSpace = height - spacing(QStyle::PM_LayoutVerticalSpacing);
+        for (auto it = m_rows.cbegin(); it != m_rows.cend(); ++it) {
+            const int y = it.key() * height - offset;
+            it.value().label->setGeometry(0, y, m_labelWidth, rowSpace);
+            it.value().field->setGeometry(m_labelWidth + horizontalSpacing, y, fieldWidth, rowSpace);
+            it.value().label->show();
+            it.value().field->show();
+        }
+    }
+
+    Slot acquire()
+    {
+        if (!m_unused.isEmpty()) {
+            return m_unused.takeLast();
+        }
+        Slot slot{ new QLabel(viewport()), m_createField() };
+        slot.field->setParent(viewport());
+        return slot;
+    }
+
+    void bind(int row, const Slot &slot)
+    {
+        m_bindRow(row, slot.label, slot.field);
+        m_labelWidth = std::max(m_labelWidth, slot.label->sizeHint().width());
+    }
+
+    void recycle(const Slot &slot)
+    {
+        slot.label->hide();
+        slot.field->hide();
+        m_unused.append(slot);
+    }
+
+    int m_rowCount;
+    FieldFactory m_createField;
+    RowBinder m_bindRow;
+    int m_overscan = 4;
+    int m_labelWidth = 0;
+    int m_rowHeight = 0;
+    QHash<int, Slot> m_rows;
+    QVector<Slot> m_unused;
+};
@@ -2,13 +2,14 @@
 #include <QFrame>
 
 #include "qtutils/layouts.h"
+#include "qtutils/styleclasses.h"
 
 class Frame : public QFrame
 {
 public:
     explicit Frame(QWidget *parent = nullptr) : QFrame(parent)
     {
-        setStyleSheet("background: gray;");
+        StyleClasses::apply(this, "frame");
     }
 
     QSize minimumSizeHint() const
@@ -20,6 +21,9 @@ public:
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    StyleClasses::define("frame", "background: gray;");
+    StyleClasses::define("highlighted", "border: 2px solid orange;");
+
     QWidget w;
 
     Frame *nullWidget =  nullptr;
@@ -28,9 +32,9 @@ int main(int argc, char *argv[])
                     << nullWidget
                     << Spacing(5)
                     << (new Frame())
-                    << Stretch(new Frame(), 1)
-                    << Stretch(HBox()
-                        << Stretch(new Frame(), 1)
+                    << Stretched(new Frame(), 1)
+                    << Stretched(HBox()
+                        << Stretched(Styled(new Frame(), "frame highlighted"), 1)
                         << (new Frame())));
 
     w.show();